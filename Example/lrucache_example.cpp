@@ -1,9 +1,19 @@
 // lrucache_test.cpp
 #include "LRUCache.h"
+#include "ShardedLRUCache.h"
+#include "SlabLRUCache.h"
+#include "ClockCache.h"
 #include <iostream>
 #include <cassert>
 #include <string>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <chrono>
+#include <cstdio>
+#include <vector>
 
 // 简单的值删除器，用于int类型
 struct IntDeleter {
@@ -43,6 +53,19 @@ struct TestObjectDeleter {
     }
 };
 
+// 没有 std::hash 特化、只能通过自定义哈希函数使用的 key
+struct PointKey {
+    int x;
+    int y;
+    bool operator==(const PointKey& other) const { return x == other.x && y == other.y; }
+};
+
+struct PointKeyHash {
+    size_t operator()(const PointKey& key) const {
+        return std::hash<int>()(key.x) * 31 + std::hash<int>()(key.y);
+    }
+};
+
 void test_basic_operations() {
     std::cout << "=== Test 1: Basic Operations ===" << std::endl;
     
@@ -401,6 +424,771 @@ void test_complex_types() {
     std::cout << "Test 9 passed!" << std::endl;
 }
 
+void test_sharded_cache() {
+    std::cout << "\n=== Test 10: Sharded Cache ===" << std::endl;
+
+    ShardedLRUCache<int, int, IntDeleter> cache(3);
+    cache.set_max_size(64);
+    assert(cache.get_num_shards() == 8);
+
+    // 单线程语义与 LRUCache 一致
+    {
+        auto handle = cache.put(1, 100);
+        assert(handle.valid());
+        assert(cache.del(1));
+        assert(handle.value() == 100);
+        assert(!cache.get(1).valid());
+    }
+
+    // 多线程并发读写，容量按分片切分后总量不超过 64 + 分片取整余量
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&cache, t]() {
+            for (int i = 0; i < 10000; i++) {
+                int key = (i * 7 + t) % 256;
+                {
+                    auto handle = cache.get(key);
+                    if (handle.valid()) {
+                        assert(handle.value() == key * 10);
+                    }
+                }
+                // 每个 key 只由一个线程写入
+                if (key % 4 == t) {
+                    auto handle = cache.put(key, key * 10);
+                    assert(handle.value() == key * 10);
+                    if (i % 97 == 0) {
+                        cache.del(key);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    assert(cache.get_size() <= 64);
+
+    cache.prune();
+    assert(cache.get_size() == 0);
+
+    // 自定义哈希函数同时用于分片选择和分片内的哈希表
+    ShardedLRUCache<PointKey, int, IntDeleter, PointKeyHash> points(2);
+    for (int i = 0; i < 32; i++) {
+        points.put(PointKey{i, -i}, i);
+    }
+    for (int i = 0; i < 32; i++) {
+        auto handle = points.get(PointKey{i, -i});
+        assert(handle.valid() && handle.value() == i);
+    }
+    assert(!points.get(PointKey{1, 1}).valid());
+
+    std::cout << "Test 10 passed!" << std::endl;
+}
+
+void test_slab_cache() {
+    std::cout << "\n=== Test 11: Slab Cache ===" << std::endl;
+
+    // 基本语义与 LRUCache 一致
+    {
+        SlabLRUCache<int, int, IntDeleter> cache(3);
+        cache.put(1, 100);
+        cache.put(2, 200);
+        cache.put(3, 300);
+        {
+            auto handle = cache.get(1);
+            assert(handle.valid());
+        }
+        cache.put(4, 400);     // 淘汰 key 2
+        assert(cache.get_size() == 3);
+        assert(!cache.get(2).valid());
+        assert(cache.get(1).valid());
+
+        // 外部持有时删除，句柄仍然可用
+        auto handle = cache.get(3);
+        assert(cache.del(3));
+        assert(handle.value() == 300);
+        assert(!cache.get(3).valid());
+    }
+
+    // 全部节点被外部持有时 put 失败
+    {
+        SlabLRUCache<std::string, TestObject, TestObjectDeleter> cache(2);
+        auto h1 = cache.put("a", TestObject(1, "a"));
+        auto h2 = cache.put("b", TestObject(2, "b"));
+        auto h3 = cache.put("c", TestObject(3, "c"));
+        assert(h1.valid() && h2.valid());
+        assert(!h3.valid());
+        assert(cache.get_size() == 2);
+    }
+
+    // 与 LRUCache 对拍：相同的操作序列得到相同的命中结果
+    {
+        SlabLRUCache<int, int, IntDeleter> slab(64);
+        LRUCache<int, int, IntDeleter> reference;
+        reference.set_max_size(64);
+        unsigned seed = 12345;
+        for (int i = 0; i < 100000; i++) {
+            seed = seed * 1103515245 + 12345;
+            int key = (seed >> 16) % 200;
+            int op = (seed >> 8) % 10;
+            if (op < 5) {
+                auto a = slab.get(key);
+                auto b = reference.get(key);
+                assert(a.valid() == b.valid());
+                assert(!a.valid() || a.value() == b.value());
+            } else if (op < 9) {
+                slab.put(key, i);
+                reference.put(key, i);
+            } else {
+                assert(slab.del(key) == reference.del(key));
+            }
+            assert(slab.get_size() == reference.get_size());
+        }
+    }
+
+    std::cout << "Test 11 passed!" << std::endl;
+}
+
+void test_charge_capacity() {
+    std::cout << "\n=== Test 12: Charge Capacity ===" << std::endl;
+
+    LRUCache<std::string, std::string, DefaultValueDeleter<std::string>> cache;
+    cache.set_max_size(1000);   // 1000 字节
+
+    cache.put("small1", std::string(100, 'a'), 100);
+    cache.put("small2", std::string(100, 'b'), 100);
+    cache.put("big", std::string(700, 'c'), 700);
+    assert(cache.get_size() == 3);
+    assert(cache.get_usage() == 900);
+    assert(cache.get_pinned_usage() == 0);
+
+    // 插入 200 字节，淘汰最久未使用的 small1
+    cache.put("medium", std::string(200, 'd'), 200);
+    assert(!cache.get("small1").valid());
+    assert(cache.get_usage() == 1000);
+
+    {
+        // 持有 big 时插入超出容量的条目：big 不可淘汰，其余按 LRU 淘汰
+        auto big = cache.get("big");
+        assert(cache.get_pinned_usage() == 700);
+        auto huge = cache.put("huge", std::string(500, 'e'), 500);
+        assert(huge.valid());
+        assert(cache.get_pinned_usage() == 1200);
+        assert(!cache.get("small2").valid());
+        assert(!cache.get("medium").valid());
+        assert(cache.get_usage() == 1200);
+
+        // 删除后仍被引用，计入 pinned_usage 但不计入 usage
+        cache.del("big");
+        assert(cache.get_usage() == 500);
+        assert(cache.get_pinned_usage() == 1200);
+    }
+    assert(cache.get_pinned_usage() == 0);
+    assert(cache.get_usage() == 500);
+
+    // 更新已存在的 key 会同时更新 charge
+    cache.put("huge", std::string(10, 'f'), 10);
+    assert(cache.get_usage() == 10);
+
+    // 单个条目超过容量：句柄释放后立即淘汰
+    cache.put("oversize", std::string(2000, 'g'), 2000);
+    assert(!cache.get("oversize").valid());
+    assert(cache.get_usage() <= 1000);
+
+    std::cout << "Test 12 passed!" << std::endl;
+}
+
+// 热点集合反复访问后经历一次全量扫描，返回扫描后仍命中的热点数量
+template<class Cache>
+int hot_hits_after_scan(Cache& cache) {
+    cache.set_max_size(100);
+    for (int round = 0; round < 4; round++) {
+        for (int key = 0; key < 50; key++) {
+            if (!cache.get(key).valid()) {
+                cache.put(key, key);
+            }
+        }
+    }
+    for (int key = 1000; key < 2000; key++) {
+        if (!cache.get(key).valid()) {
+            cache.put(key, key);
+        }
+    }
+    int hits = 0;
+    for (int key = 0; key < 50; key++) {
+        hits += cache.get(key).valid() ? 1 : 0;
+    }
+    return hits;
+}
+
+void test_eviction_policy() {
+    std::cout << "\n=== Test 13: Eviction Policy ===" << std::endl;
+
+    LRUCache<int, int, IntDeleter> lru;
+    LRUCache<int, int, IntDeleter, NullMutex, SLRUPolicy> slru;
+    LRUCache<int, int, IntDeleter, NullMutex, TinyLFUPolicy<>> tinylfu;
+
+    // 扫描会冲刷纯 LRU 的热点，分段 / 准入策略应保留热点
+    assert(hot_hits_after_scan(lru) == 0);
+    assert(hot_hits_after_scan(slru) == 50);
+    assert(hot_hits_after_scan(tinylfu) == 50);
+    assert(slru.get_size() == 100);
+    assert(tinylfu.get_size() <= 100);
+
+    // SLRU 基本语义：命中晋升，淘汰优先 probation
+    {
+        LRUCache<int, int, IntDeleter, NullMutex, SLRUPolicy> cache;
+        cache.set_max_size(5);      // protected 配额 4
+        for (int key = 0; key < 5; key++) {
+            cache.put(key, key);
+        }
+        cache.get(0);               // 0 晋升到 protected
+        cache.put(5, 5);            // 淘汰 probation 头部的 1
+        assert(!cache.get(1).valid());
+        assert(cache.get(0).valid());
+        assert(cache.del(0));
+        assert(cache.get_size() == 4);
+    }
+
+    // TinyLFU：未通过准入的条目仍返回有效句柄，但不进入缓存
+    {
+        LRUCache<int, int, IntDeleter, NullMutex, TinyLFUPolicy<>> cache;
+        cache.set_max_size(2);
+        for (int i = 0; i < 5; i++) {
+            cache.get(1);
+            cache.get(2);
+        }
+        cache.put(1, 1);
+        cache.put(2, 2);
+        {
+            auto handle = cache.put(3, 3);
+            assert(handle.valid() && handle.value() == 3);
+            assert(cache.get_pinned_usage() == 1);
+        }
+        assert(cache.get_pinned_usage() == 0);
+        assert(!cache.get(3).valid());
+        assert(cache.get(1).valid() && cache.get(2).valid());
+    }
+
+    // 分片缓存透传策略
+    {
+        ShardedLRUCache<int, int, IntDeleter, std::hash<int>, SLRUPolicy> cache(2);
+        cache.set_max_size(400);
+        for (int key = 0; key < 1000; key++) {
+            cache.put(key, key);
+        }
+        assert(cache.get_size() <= 400);
+        cache.prune();
+    }
+
+    std::cout << "Test 13 passed!" << std::endl;
+}
+
+void test_batch_operations() {
+    std::cout << "\n=== Test 14: Batch Operations ===" << std::endl;
+
+    std::vector<int> keys;
+    std::vector<int> values;
+    for (int i = 0; i < 100; i++) {
+        keys.push_back(i);
+        values.push_back(i * 10);
+    }
+    std::vector<int> probe = {5, 200, 99, 5, 300, 0};
+
+    {
+        LRUCache<int, int, IntDeleter> cache;
+        cache.set_max_size(200);
+        auto put_handles = cache.multi_put(keys.data(), values.data(), keys.size());
+        assert(put_handles.size() == 100);
+        put_handles.clear();
+        assert(cache.get_size() == 100);
+
+        auto handles = cache.multi_get(probe);
+        assert(handles.size() == probe.size());
+        assert(handles[0].valid() && handles[0].value() == 50);
+        assert(!handles[1].valid());
+        assert(handles[2].valid() && handles[2].value() == 990);
+        assert(handles[3].valid() && handles[3].value() == 50);
+        assert(!handles[4].valid());
+        assert(handles[5].valid() && handles[5].value() == 0);
+    }
+
+    {
+        ShardedLRUCache<int, int, IntDeleter> cache(3);
+        cache.set_max_size(800);
+        std::vector<size_t> charges(keys.size(), 2);
+        cache.multi_put(keys.data(), values.data(), keys.size(), charges.data());
+        assert(cache.get_usage() == 200);
+
+        auto handles = cache.multi_get(probe);
+        assert(handles.size() == probe.size());
+        for (size_t i = 0; i < probe.size(); i++) {
+            assert(handles[i].valid() == (probe[i] < 100));
+            assert(!handles[i].valid() || handles[i].key() == probe[i]);
+        }
+        assert(cache.get_pinned_usage() == 6);   // 重复的 key 只计一次
+    }
+
+    {
+        // 整批句柄同时持有，批量大小超过节点池时超出部分会插入失败
+        SlabLRUCache<int, int, IntDeleter> cache(64);
+        auto put_handles = cache.multi_put(keys.data(), values.data(), keys.size());
+        assert(put_handles[63].valid() && !put_handles[64].valid());
+        put_handles.clear();
+        cache.multi_put(keys.data() + 36, values.data() + 36, 64);
+        assert(cache.get_size() == 64);
+
+        auto handles = cache.multi_get(probe);
+        assert(handles.size() == probe.size());
+        assert(handles[2].valid() && handles[2].value() == 990);
+        assert(!handles[0].valid() && !handles[1].valid());
+    }
+
+    std::cout << "Test 14 passed!" << std::endl;
+}
+
+void test_ttl_expiration() {
+    std::cout << "\n=== Test 15: TTL Expiration ===" << std::endl;
+    using namespace std::chrono_literals;
+
+    LRUCache<int, int, IntDeleter> cache;
+    cache.set_max_size(100);
+
+    cache.put(1, 100, 20ms);
+    cache.put(2, 200, 10s);
+    cache.put(3, 300);                  // 永不过期
+    assert(cache.get(1).valid());
+
+    {
+        // 被引用的节点过期后句柄仍然可用
+        auto pinned = cache.put(4, 400, 20ms);
+        std::this_thread::sleep_for(30ms);
+
+        // 过期按未命中处理并被惰性移除
+        assert(!cache.get(1).valid());
+        assert(cache.get_size() == 3);
+        assert(cache.get(2).valid());
+        assert(cache.get(3).valid());
+
+        std::this_thread::sleep_for(200ms);
+        assert(cache.expire(1024) == 1);
+        assert(pinned.valid() && pinned.value() == 400);
+        assert(cache.get_size() == 2);
+    }
+    assert(cache.get_pinned_usage() == 0);
+
+    // 重新 put 会覆盖 TTL
+    cache.put(2, 201);
+    std::this_thread::sleep_for(10ms);
+    assert(cache.get(2).valid());
+
+    // 批量过期：增量清理在预算内逐步完成
+    ShardedLRUCache<int, int, IntDeleter> sharded(2);
+    for (int key = 0; key < 200; key++) {
+        sharded.put(key, key, 1ms);
+    }
+    sharded.put(1000, 1000, 1h);
+    std::this_thread::sleep_for(250ms);
+    size_t removed = 0;
+    for (int i = 0; i < 100; i++) {
+        removed += sharded.expire(16);
+    }
+    assert(removed == 200);
+    assert(sharded.get_size() == 1);
+    sharded.prune();
+
+    std::cout << "Test 15 passed!" << std::endl;
+}
+
+void test_clock_cache() {
+    std::cout << "\n=== Test 16: Clock Cache ===" << std::endl;
+
+    // 基本语义
+    {
+        ClockCache<int, int, IntDeleter> cache(4);
+        for (int key = 0; key < 4; key++) {
+            cache.put(key, key * 10);
+        }
+        assert(cache.get_size() == 4);
+
+        // 0 和 1 被访问过，获得第二次机会
+        assert(cache.get(0).valid());
+        assert(cache.get(1).valid());
+        cache.put(4, 40);
+        assert(cache.get_size() == 4);
+        assert(cache.get(0).valid() && cache.get(1).valid());
+        assert(!cache.get(2).valid());
+
+        // 更新不影响已持有的旧值
+        auto old_handle = cache.get(4);
+        cache.put(4, 41);
+        assert(old_handle.value() == 40);
+        assert(cache.get(4).value() == 41);
+        assert(cache.get_size() == 4);
+
+        // 被引用时删除，句柄仍可用
+        assert(cache.del(4));
+        assert(!cache.get(4).valid());
+        assert(old_handle.value() == 40);
+    }
+
+    // 读多写少的并发场景：读者无锁，写者少量更新
+    {
+        ClockCache<int, int, IntDeleter> cache(128);
+        for (int key = 0; key < 128; key++) {
+            cache.put(key, key);
+        }
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([&cache, &stop, t]() {
+                unsigned seed = t;
+                while (!stop.load()) {
+                    seed = seed * 1103515245 + 12345;
+                    int key = (seed >> 16) % 160;
+                    auto handle = cache.get(key);
+                    if (handle.valid()) {
+                        assert(handle.key() == key);
+                        assert(handle.value() % 1000 == key);
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < 20000; i++) {
+            int key = i % 160;
+            if (i % 3 == 0) {
+                cache.del(key);
+            } else {
+                cache.put(key, (i / 160) * 1000 + key);
+            }
+        }
+        stop = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        assert(cache.get_size() <= 128);
+    }
+
+    std::cout << "Test 16 passed!" << std::endl;
+}
+
+// 满足 ThreadPool::Enqueue 接口的简易执行器
+struct AsyncExecutor {
+    template<typename F>
+    auto Enqueue(F&& f) -> std::future<decltype(f())> {
+        return std::async(std::launch::async, std::forward<F>(f));
+    }
+};
+
+void test_get_or_load() {
+    std::cout << "\n=== Test 17: Get Or Load ===" << std::endl;
+    using namespace std::chrono_literals;
+
+    ShardedLRUCache<int, int, IntDeleter> cache(2);
+    cache.set_max_size(100);
+
+    // 同一 key 的并发未命中只执行一次 loader
+    std::atomic<int> loads(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; t++) {
+        workers.emplace_back([&cache, &loads]() {
+            auto handle = cache.get_or_load(42, [&loads]() {
+                loads++;
+                std::this_thread::sleep_for(50ms);
+                return 4200;
+            });
+            assert(handle.valid() && handle.value() == 4200);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    assert(loads == 1);
+    assert(cache.get_pinned_usage() == 0);
+
+    // 命中时不调用 loader
+    {
+        auto handle = cache.get_or_load(42, []() -> int {
+            assert(false);
+            return 0;
+        });
+        assert(handle.value() == 4200);
+    }
+
+    // loader 异常传递给调用方，且不会留下加载记录
+    bool thrown = false;
+    try {
+        cache.get_or_load(7, []() -> int { throw std::runtime_error("load failed"); });
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(cache.get_or_load(7, []() { return 70; }).value() == 70);
+
+    // 异步版本
+    AsyncExecutor pool;
+    auto future = cache.get_or_load_async(8, []() { return 80; }, pool);
+    auto handle = future.get();
+    assert(handle.valid() && handle.value() == 80);
+    assert(cache.get_or_load_async(8, []() { return 0; }, pool).get().value() == 80);
+
+    std::cout << "Test 17 passed!" << std::endl;
+}
+
+void test_cache_stats() {
+    std::cout << "\n=== Test 18: Cache Stats ===" << std::endl;
+    using namespace std::chrono_literals;
+
+    LRUCache<int, int, IntDeleter> cache;
+    cache.set_max_size(2);
+
+    cache.put(1, 10);
+    cache.put(2, 20);
+    cache.put(1, 11);           // 更新
+    cache.get(1);               // 命中
+    cache.get(3);               // 未命中
+    cache.put(3, 30);           // 淘汰 2
+    cache.del(3);
+    cache.put(4, 40, 1ms);
+    std::this_thread::sleep_for(5ms);
+    cache.get(4);               // 过期，按未命中计
+
+    CacheStats stats = cache.get_stats();
+    assert(stats.size == cache.get_size());
+    assert(stats.usage == cache.get_usage());
+    if constexpr (kCacheStatsEnabled) {
+        assert(stats.hits == 1);
+        assert(stats.misses == 2);
+        assert(stats.inserts == 4);
+        assert(stats.updates == 1);
+        assert(stats.evictions == 1);
+        assert(stats.deletes == 1);
+        assert(stats.expirations == 1);
+        assert(stats.handle_releases == 6);
+        assert(stats.hit_ratio() > 0.3 && stats.hit_ratio() < 0.4);
+        std::cout << "avg handle lifetime: " << stats.avg_handle_lifetime_ns() << " ns" << std::endl;
+    } else {
+        assert(stats.hits == 0 && stats.misses == 0);
+    }
+    if constexpr (kCacheLatencyEnabled) {
+        assert(stats.get_latency.count == 3);
+        assert(stats.put_latency.count == 5);
+        std::cout << "get p50 <= " << stats.get_latency.percentile(0.5) << " ns, "
+                  << "put p99 <= " << stats.put_latency.percentile(0.99) << " ns" << std::endl;
+    }
+
+    cache.reset_stats();
+    assert(cache.get_stats().hits == 0);
+
+    // 分片缓存汇总各分片的统计
+    ShardedLRUCache<int, int, IntDeleter> sharded(2);
+    for (int i = 0; i < 16; i++) {
+        sharded.put(i, i);
+    }
+    for (int i = 0; i < 32; i++) {
+        sharded.get(i);
+    }
+    CacheStats total = sharded.get_stats();
+    assert(total.size == 16);
+    if constexpr (kCacheStatsEnabled) {
+        assert(total.inserts == 16);
+        assert(total.hits == 16 && total.misses == 16);
+    }
+
+    std::cout << "Test 18 passed!" << std::endl;
+}
+
+void test_snapshot() {
+    std::cout << "\n=== Test 19: Snapshot ===" << std::endl;
+    using namespace std::chrono_literals;
+    const std::string path = "/tmp/lrucache_example.snapshot";
+
+    {
+        LRUCache<int, std::string> cache;
+        cache.set_max_size(10);
+        for (int i = 0; i < 5; i++) {
+            cache.put(i, "value" + std::to_string(i), 2);
+        }
+        cache.get(0);                                   // 0 变为最近使用
+        cache.put(5, std::string("short-lived"), 1ms);  // 淘汰 1，且保存前已过期
+        std::this_thread::sleep_for(5ms);
+        auto pinned = cache.get(2);                     // in_use 中的节点同样写入快照
+        assert(cache.save_snapshot(path));
+    }
+
+    // 容量足够：全部恢复，顺序保持不变（最久未使用的 3 最先被淘汰）
+    {
+        LRUCache<int, std::string> cache;
+        cache.set_max_size(8);
+        assert(cache.load_snapshot(path) == 4);
+        assert(cache.get_size() == 4 && cache.get_usage() == 8);
+        assert(!cache.get(1).valid() && !cache.get(5).valid());
+        assert(cache.get(0).value() == "value0");
+        cache.put(6, std::string("value6"), 2);
+        assert(!cache.get(3).valid());
+        assert(cache.get(2).valid() && cache.get(4).valid());
+    }
+
+    // 容量不足：只恢复最近使用的条目；已在缓存中的 key 保留现有值
+    {
+        LRUCache<int, std::string> cache;
+        cache.set_max_size(6);
+        cache.put(2, std::string("live"), 2);
+        assert(cache.load_snapshot(path) == 2);
+        assert(cache.get(2).value() == "live");
+        assert(cache.get(0).valid() && cache.get(4).valid() && !cache.get(3).valid());
+        assert(cache.get_usage() == 6);
+    }
+
+    // 文件不存在或被截断时不修改缓存
+    {
+        LRUCache<int, std::string> cache;
+        assert(cache.load_snapshot("/tmp/lrucache_example.missing") == 0);
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        assert(file);
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fclose(file);
+        assert(truncate(path.c_str(), length - 3) == 0);
+        assert(cache.load_snapshot(path) == 0);
+        assert(cache.get_size() == 0);
+    }
+    std::remove(path.c_str());
+
+    std::cout << "Test 19 passed!" << std::endl;
+}
+
+void test_concurrent_update() {
+    std::cout << "\n=== Test 20: Concurrent Update ===" << std::endl;
+
+    // 更新放入新节点：读者持有的旧句柄看到的值不会在锁外被改写
+    ShardedLRUCache<int, std::string> cache(2);
+    cache.set_max_size(16);
+    {
+        auto old_handle = cache.put(1, std::string("old"));
+        cache.put(1, std::string("new"));
+        assert(old_handle.value() == "old");
+        assert(cache.get(1).value() == "new");
+        assert(cache.get_size() == 1);
+        assert(cache.get_pinned_usage() == 1);
+    }
+    assert(cache.get_pinned_usage() == 0);
+    // "new" 不满足下面的长度与字符的对应关系，读线程可能在第一次更新前读到它
+    assert(cache.del(1));
+
+    // 写线程反复更新同一个 key，读线程在锁外读取值：每个值都由同一个字符组成，长度与字符对应
+    std::atomic<bool> stop(false);
+    std::thread writer([&]() {
+        for (int i = 0; i < 20000; i++) {
+            size_t length = 1 + i % 64;
+            cache.put(1, std::string(length, static_cast<char>('a' + length % 26)));
+        }
+        stop = true;
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                auto handle = cache.get(1);
+                if (handle.valid()) {
+                    const std::string& value = handle.value();
+                    assert(!value.empty());
+                    assert(value[0] == static_cast<char>('a' + value.size() % 26));
+                    assert(value.find_first_not_of(value[0]) == std::string::npos);
+                }
+            }
+        });
+    }
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    assert(cache.get_size() == 1);
+    assert(cache.get_pinned_usage() == 0);
+
+    // 分段策略下更新 protected 段中的条目后仍在 protected 段，不会先于 probation 中的条目被淘汰
+    LRUCache<int, int, IntDeleter, NullMutex, SLRUPolicy> slru;
+    slru.set_max_size(4);
+    slru.put(1, 10);
+    assert(slru.get(1).valid());   // 1 晋升 protected
+    slru.put(1, 11);
+    slru.put(2, 20);
+    slru.put(3, 30);
+    slru.put(4, 40);
+    slru.put(5, 50);
+    assert(slru.get(1).valid() && slru.get(1).value() == 11);
+    assert(!slru.get(2).valid());
+
+    std::cout << "Test 20 passed!" << std::endl;
+}
+
+// 统计被清理的指针值并释放它们
+struct CountingPtrDeleter {
+    static int deleted;
+    void operator()(int*& value) {
+        delete value;
+        value = nullptr;
+        deleted++;
+    }
+};
+
+int CountingPtrDeleter::deleted = 0;
+
+void test_slab_concurrent_update() {
+    std::cout << "\n=== Test 21: Slab Cache Concurrent Update ===" << std::endl;
+
+    // 更新时旧值交给 ValueDeleter：无人引用时立即清理，外部持有时等句柄释放
+    {
+        SlabLRUCache<int, int*, CountingPtrDeleter> cache(4);
+        CountingPtrDeleter::deleted = 0;
+        cache.put(1, new int(1));
+        cache.put(1, new int(2));
+        assert(CountingPtrDeleter::deleted == 1);
+        {
+            auto old_handle = cache.get(1);
+            cache.put(1, new int(3));
+            assert(*old_handle.value() == 2);
+            assert(*cache.get(1).value() == 3);
+            assert(cache.get_size() == 1);
+            assert(CountingPtrDeleter::deleted == 1);
+        }
+        assert(CountingPtrDeleter::deleted == 2);
+    }
+    assert(CountingPtrDeleter::deleted == 3);
+
+    // 写线程反复更新同一个 key，读线程在锁外读取值：每个值都由同一个字符组成，长度与字符对应
+    SlabLRUCache<int, std::string, DefaultValueDeleter<std::string>, std::mutex> cache(16);
+    std::atomic<bool> stop(false);
+    std::thread writer([&]() {
+        for (int i = 0; i < 20000; i++) {
+            size_t length = 1 + i % 64;
+            cache.put(1, std::string(length, static_cast<char>('a' + length % 26)));
+        }
+        stop = true;
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                auto handle = cache.get(1);
+                if (handle.valid()) {
+                    const std::string& value = handle.value();
+                    assert(!value.empty());
+                    assert(value[0] == static_cast<char>('a' + value.size() % 26));
+                    assert(value.find_first_not_of(value[0]) == std::string::npos);
+                }
+            }
+        });
+    }
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    assert(cache.get_size() == 1);
+
+    std::cout << "Test 21 passed!" << std::endl;
+}
+
 int main() {
     try {
         test_basic_operations();
@@ -412,6 +1200,18 @@ int main() {
         test_prune_operation();
         test_edge_cases();
         test_complex_types();
+        test_sharded_cache();
+        test_slab_cache();
+        test_charge_capacity();
+        test_eviction_policy();
+        test_batch_operations();
+        test_ttl_expiration();
+        test_clock_cache();
+        test_get_or_load();
+        test_cache_stats();
+        test_snapshot();
+        test_concurrent_update();
+        test_slab_concurrent_update();
         
         std::cout << "\n=== All tests passed! ===" << std::endl;
         return 0;
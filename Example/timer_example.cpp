@@ -1,11 +1,143 @@
 #include <Timer.h>
 #include <iostream>
+#include <cassert>
+#include <set>
 #include <thread>
+#include <vector>
 #include <sys/epoll.h>
+#include <unistd.h>
 
 using namespace std;
 
-int main() {
+// 测试中直接以虚拟时间调用 HandleTimer，不必真的等待
+uint64_t g_now = 0;
+
+void advance(Timer& timer, uint64_t now) {
+    g_now = now;
+    timer.HandleTimer(now);
+}
+
+// 周期定时器按 首次到期时间 + k * interval 重新挂回，回调执行得晚不会让之后的周期漂移
+void test_periodic_no_drift() {
+    cout << "=== Test 1: Periodic Timer Without Drift ===" << endl;
+
+    Timer timer;
+    const uint64_t interval = 100;
+    vector<uint64_t> expires;
+    uint64_t before = Timer::GetTick();
+    TimerId id = timer.AddPeriodicTimer(interval, [&](TimerTask* task) {
+        assert(task->ExpireTime() <= g_now);
+        expires.push_back(task->ExpireTime());
+    });
+    uint64_t first = before + interval;
+
+    // 每次都晚一些处理，晚的程度各不相同
+    uint64_t lateness[] = {1, 7, 35, 0, 90, 3};
+    uint64_t now = first;
+    for (uint64_t late : lateness) {
+        advance(timer, now + late + 1);
+        now += interval;
+    }
+    assert(expires.size() == 6);
+    for (size_t i = 1; i < expires.size(); i++) {
+        assert(expires[i] - expires[i - 1] == interval);
+    }
+    // 首次到期时间取决于添加时读到的时钟
+    assert(expires[0] >= first && expires[0] <= first + 1);
+
+    // 错过的周期直接跳过：一次处理只执行一次，下一次仍对齐到原来的节拍
+    uint64_t last = expires.back();
+    advance(timer, last + 3 * interval + 50);
+    assert(expires.size() == 7);
+    advance(timer, last + 4 * interval - 1);
+    assert(expires.size() == 7);
+    advance(timer, last + 4 * interval);
+    assert(expires.size() == 8);
+    assert(expires.back() == last + 4 * interval);
+
+    assert(timer.DelTimer(id));
+    assert(timer.WaitTime() == static_cast<uint>(-1));
+
+    cout << "Test 1 passed!" << endl;
+}
+
+// 周期定时器在自己的回调中删除自身：删除成功，之后不再触发，节点被回收
+void test_periodic_cancel_in_callback() {
+    cout << "\n=== Test 2: Cancel Periodic Timer In Its Callback ===" << endl;
+
+    Timer timer;
+    int count = 0;
+    bool deleted = false;
+    TimerId id;
+    id = timer.AddPeriodicTimer(10, [&](TimerTask*) {
+        if (++count == 3) {
+            deleted = timer.DelTimer(id);
+            assert(!timer.DelTimer(id));
+        }
+    });
+
+    uint64_t start = Timer::GetTick();
+    for (uint64_t t = start; t <= start + 200; t++) {
+        advance(timer, t);
+    }
+    assert(count == 3);
+    assert(deleted);
+    assert(!timer.DelTimer(id));
+    assert(timer.WaitTime() == static_cast<uint>(-1));
+
+    // 节点已回到空闲链表，新定时器复用它，旧句柄删不掉新定时器
+    TimerId reused = timer.AddTimer(10, [](TimerTask*) {});
+    assert(reused.index == id.index && reused.generation != id.generation);
+    assert(!timer.DelTimer(id));
+    assert(timer.DelTimer(reused));
+
+    cout << "Test 2 passed!" << endl;
+}
+
+// 到期时间相近、slack 窗口有公共对齐点的定时器合并到同一时刻触发，只需一次唤醒
+void test_slack_coalescing() {
+    cout << "\n=== Test 3: Slack Coalescing ===" << endl;
+
+    Timer timer;
+    const uint64_t slack = 30;
+    // 取一个 1024 对齐的时刻，它前后 slack 内的其他时刻低位 0 都更少
+    uint64_t start = Timer::GetTick();
+    uint64_t target = ((start + 100) / 1024 + 1) * 1024;
+    set<uint64_t> fire_times;
+    int fired = 0;
+    const int count = 19;
+    for (int i = 0; i < count; i++) {
+        uint64_t deadline = target - 2 - i;
+        timer.AddTimer(deadline - Timer::GetTick(), [&](TimerTask* task) {
+            assert(task->ExpireTime() <= g_now);
+            fire_times.insert(g_now);
+            fired++;
+        }, slack);
+    }
+    // 对照：不带 slack 的定时器按自己的到期时间触发
+    uint64_t exact = 0;
+    timer.AddTimer(target - 10 - Timer::GetTick(), [&](TimerTask* task) { exact = task->ExpireTime(); });
+
+    int wakeups = 0;
+    for (uint64_t t = start; t <= target + slack; t++) {
+        int before = fired;
+        advance(timer, t);
+        if (fired != before) {
+            wakeups++;
+        }
+    }
+    assert(fired == count);
+    assert(wakeups == 1);
+    assert(fire_times.size() == 1 && *fire_times.begin() == target);
+    assert(exact != 0 && exact < target - 2);
+
+    cout << "Test 3 passed!" << endl;
+}
+
+// 演示：在 epoll_wait 循环中驱动定时器，3 秒后删除周期定时器，定时器全部结束后退出
+void run_demo() {
+    cout << "\n=== Demo ===" << endl;
+
     int epfd = epoll_create(1);
 
     unique_ptr<Timer> timer = make_unique<Timer>();
@@ -21,19 +153,25 @@ int main() {
         cout << Timer::GetTick() << " addtime:" << task->AddTime() << " revoked times:" << ++i << endl;
     });
 
-    timer->AddTimer(3000, [&](TimerTask *task) {
-        cout << Timer::GetTick() << " addtime:" << task->AddTime() << " revoked times:" << ++i << endl;
-    });
-
     auto task = timer->AddTimer(2100, [&](TimerTask *task) {
         cout << Timer::GetTick() << " addtime:" << task->AddTime() << " revoked times:" << ++i << endl;
     });
 
     timer->DelTimer(task);
+
+    // 周期定时器：每 500ms 触发一次，允许推迟 10ms 以便与其他定时器合并唤醒
+    auto periodic = timer->AddPeriodicTimer(500, [&](TimerTask *task) {
+        cout << Timer::GetTick() << " periodic expire:" << task->ExpireTime() << endl;
+    }, 10);
+
+    timer->AddTimer(3000, [&](TimerTask *task) {
+        cout << Timer::GetTick() << " addtime:" << task->AddTime() << " revoked times:" << ++i << endl;
+        timer->DelTimer(periodic);
+    });
     cout << "now time:" << Timer::GetTick() << endl;
     epoll_event ev[64] = {0};
 
-    while (true) {
+    while (timer->WaitTime() != static_cast<uint>(-1)) {
         cout << "waittime:" << timer->WaitTime() << endl;
         int n = epoll_wait(epfd, ev, 64, timer->WaitTime());
         time_t now = Timer::GetTick();
@@ -43,6 +181,17 @@ int main() {
         /* 处理定时事件*/
         timer->HandleTimer(now);
     }
-    
+    assert(i == 3);
+    close(epfd);
+}
+
+int main() {
+    test_periodic_no_drift();
+    test_periodic_cancel_in_callback();
+    test_slack_coalescing();
+
+    cout << "\n=== All tests passed! ===" << endl;
+
+    run_demo();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,140 @@
+// CacheSnapshot.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// LRUCache 快照（预热）支持
+// 文件格式（本机字节序，不跨架构使用）：
+//   SnapshotHeader | 记录 * count
+//   记录 = charge(u64) | 剩余 TTL 毫秒(u64，0 表示永不过期) | key | value
+// 记录按从新到旧（MRU -> LRU）排列，恢复时容量用完即可停止读取，不必解析注定会被淘汰的旧条目
+// key / value 的编码由 CacheSerializer<T> 决定：平凡可拷贝类型按字节拷贝，std::string 为长度 + 内容，
+// 其他类型需自行特化
+
+template<typename T, typename = void>
+struct CacheSerializer {
+    static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>,
+                  "该类型需要特化 CacheSerializer 才能写入快照");
+
+    static void write(std::string& out, const T& value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // 从 [pos, end) 读取一个值并推进 pos，数据不足时返回 false
+    static bool read(const char*& pos, const char* end, T& value)
+    {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+};
+
+template<>
+struct CacheSerializer<std::string> {
+    static void write(std::string& out, const std::string& value)
+    {
+        CacheSerializer<uint64_t>::write(out, value.size());
+        out.append(value);
+    }
+
+    static bool read(const char*& pos, const char* end, std::string& value)
+    {
+        uint64_t length = 0;
+        if (!CacheSerializer<uint64_t>::read(pos, end, length) ||
+            static_cast<uint64_t>(end - pos) < length) {
+            return false;
+        }
+        value.assign(pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+struct SnapshotHeader {
+    static constexpr char kMagic[8] = {'L', 'R', 'U', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;     // 记录条数
+};
+
+// 只读映射整个快照文件，析构时解除映射
+class MappedFile {
+public:
+    MappedFile() : addr(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        // 恢复时顺序读取整份文件
+        ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+        addr = p;
+        length = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    void close()
+    {
+        if (addr) {
+            ::munmap(addr, length);
+            addr = nullptr;
+            length = 0;
+        }
+    }
+
+    const char* data() const { return static_cast<const char*>(addr); }
+    size_t size() const { return length; }
+
+private:
+    void* addr;
+    size_t length;
+};
+
+// 先写临时文件再 rename，保证快照文件要么是旧的、要么是完整的新文件
+inline bool write_snapshot_file(const std::string& path, const std::string& data)
+{
+    std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
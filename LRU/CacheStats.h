@@ -0,0 +1,167 @@
+// CacheStats.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// 缓存统计（编译期开关，默认关闭；关闭时计数、计时代码全部被 if constexpr 去掉）
+// -DLRU_CACHE_STATS   : 命中 / 未命中 / 插入 / 更新 / 淘汰 / 过期 / 删除 / 准入拒绝计数，以及句柄持有时长
+// -DLRU_CACHE_LATENCY : get / put 延迟直方图（每次操作额外读取两次时钟）
+// 计数在各分片的锁内累加，读取时由 ShardedLRUCache 汇总
+#ifdef LRU_CACHE_STATS
+inline constexpr bool kCacheStatsEnabled = true;
+#else
+inline constexpr bool kCacheStatsEnabled = false;
+#endif
+
+#ifdef LRU_CACHE_LATENCY
+inline constexpr bool kCacheLatencyEnabled = true;
+#else
+inline constexpr bool kCacheLatencyEnabled = false;
+#endif
+
+inline uint64_t cache_now_ns()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 延迟直方图：第 i 个桶统计 [2^i, 2^(i+1)) 纳秒
+struct LatencyHistogram {
+    static constexpr int kBuckets = 40;
+
+    uint64_t buckets[kBuckets] = {};
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+
+    void record(uint64_t ns)
+    {
+        int index = 0;
+        while (index + 1 < kBuckets && (ns >> (index + 1)) != 0) {
+            index++;
+        }
+        buckets[index]++;
+        count++;
+        total_ns += ns;
+    }
+
+    // 返回 p 分位（0 ~ 1）所在桶的上界（纳秒）
+    uint64_t percentile(double p) const
+    {
+        uint64_t target = static_cast<uint64_t>(p * count);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += buckets[i];
+            if (seen > target) {
+                return uint64_t(1) << (i + 1);
+            }
+        }
+        return count == 0 ? 0 : uint64_t(1) << kBuckets;
+    }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < kBuckets; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        total_ns += other.total_ns;
+        return *this;
+    }
+};
+
+// 未开启 LRU_CACHE_LATENCY 时代替 LatencyHistogram 的空类型，接口相同、不记录任何数据，
+// 每个缓存（及每个分片）不必为用不上的桶付出内存
+struct NullLatencyHistogram {
+    static constexpr uint64_t count = 0;
+    static constexpr uint64_t total_ns = 0;
+
+    void record(uint64_t) {}
+    uint64_t percentile(double) const { return 0; }
+    NullLatencyHistogram& operator+=(const NullLatencyHistogram&) { return *this; }
+};
+
+using CacheLatencyHistogram = std::conditional_t<kCacheLatencyEnabled, LatencyHistogram, NullLatencyHistogram>;
+
+// 计时器：未开启 LRU_CACHE_LATENCY 时不读取时钟
+class LatencyTimer {
+public:
+    LatencyTimer() : start(kCacheLatencyEnabled ? cache_now_ns() : 0) {}
+
+    void record_to(CacheLatencyHistogram& histogram) const
+    {
+        if constexpr (kCacheLatencyEnabled) {
+            histogram.record(cache_now_ns() - start);
+        }
+    }
+
+private:
+    uint64_t start;
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t updates = 0;
+    uint64_t evictions = 0;             // 因容量不足被淘汰
+    uint64_t expirations = 0;           // 因 TTL 到期被移除
+    uint64_t deletes = 0;               // 被 del 显式删除
+    uint64_t rejections = 0;            // 未通过准入策略
+    uint64_t handle_releases = 0;       // 已释放的句柄数
+    uint64_t handle_lifetime_ns = 0;    // 句柄持有总时长
+    uint64_t max_handle_lifetime_ns = 0;
+
+    // 读取时的快照
+    size_t size = 0;
+    size_t usage = 0;
+    size_t pinned_usage = 0;
+
+    // 只在开启 LRU_CACHE_LATENCY 时为 LatencyHistogram
+    CacheLatencyHistogram get_latency;
+    CacheLatencyHistogram put_latency;
+
+    double hit_ratio() const
+    {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+
+    uint64_t avg_handle_lifetime_ns() const
+    {
+        return handle_releases == 0 ? 0 : handle_lifetime_ns / handle_releases;
+    }
+
+    void record_handle_release(uint64_t lifetime_ns)
+    {
+        handle_releases++;
+        handle_lifetime_ns += lifetime_ns;
+        if (lifetime_ns > max_handle_lifetime_ns) {
+            max_handle_lifetime_ns = lifetime_ns;
+        }
+    }
+
+    CacheStats& operator+=(const CacheStats& other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        inserts += other.inserts;
+        updates += other.updates;
+        evictions += other.evictions;
+        expirations += other.expirations;
+        deletes += other.deletes;
+        rejections += other.rejections;
+        handle_releases += other.handle_releases;
+        handle_lifetime_ns += other.handle_lifetime_ns;
+        if (other.max_handle_lifetime_ns > max_handle_lifetime_ns) {
+            max_handle_lifetime_ns = other.max_handle_lifetime_ns;
+        }
+        size += other.size;
+        usage += other.usage;
+        pinned_usage += other.pinned_usage;
+        get_latency += other.get_latency;
+        put_latency += other.put_latency;
+        return *this;
+    }
+};
@@ -0,0 +1,347 @@
+// ClockCache.h
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include "LRUCache.h"
+
+// ClockCache 实现：读路径无锁的 CLOCK 缓存（面向读多写少、高命中率的场景）
+// 核心设计：
+// 1. 节点直接存放在开放寻址表的槽位中，每个槽位一个 64 位原子 meta：状态 + 访问位 + 引用计数
+//    状态：EMPTY（空）/ CONSTRUCTION（写者独占）/ VISIBLE（在缓存中）/ INVISIBLE（已移出但仍被引用）
+// 2. get 命中只做一次 fetch_add 增加引用，必要时再置访问位，不加锁、不调整任何链表
+// 3. put / del / 淘汰由写者在 mutex 内完成；淘汰由 CLOCK 指针扫描：有引用跳过，访问位为 1 清零给第二次机会
+// 4. 每个槽位记录有多少条探测链经过它（displacements），查找遇到 0 即可停止，因此删除无需墓碑
+// 5. 读者对非 VISIBLE 槽位的临时加引用会立即撤销；写者只用精确值 CAS 抢占无引用的槽位，
+//    状态切换使用 fetch_add 保留读者的临时引用
+// 6. 更新已存在的 key 时插入新槽位并把旧槽位移出缓存，已持有旧值的句柄不受影响
+template<typename KEY, typename VALUE, class ValueDeleter = DefaultValueDeleter<VALUE>,
+         class Hash = std::hash<KEY>>
+class ClockCache {
+private:
+    static constexpr uint64_t kRefMask = 0xFFFFFFFFull;
+    static constexpr uint64_t kAccessBit = uint64_t(1) << 59;
+    static constexpr int kStateShift = 60;
+    static constexpr uint64_t kStateMask = uint64_t(3) << kStateShift;
+    static constexpr uint64_t kEmpty = uint64_t(0) << kStateShift;
+    static constexpr uint64_t kConstruction = uint64_t(1) << kStateShift;
+    static constexpr uint64_t kVisible = uint64_t(2) << kStateShift;
+    static constexpr uint64_t kInvisible = uint64_t(3) << kStateShift;
+
+    struct Slot {
+        std::atomic<uint64_t> meta{0};
+        std::atomic<uint32_t> displacements{0};     // 经过该槽位的探测链数量
+        uint64_t hash = 0;
+        std::optional<KEY> key;
+        std::optional<VALUE> value;
+    };
+
+public:
+    // RAII 安全句柄：自动管理引用计数
+    class HandleGuard {
+    public:
+        ~HandleGuard() {
+            reset();
+        }
+
+        // 禁用拷贝
+        HandleGuard(const HandleGuard&) = delete;
+        HandleGuard& operator=(const HandleGuard&) = delete;
+        // 禁用移动赋值
+        HandleGuard& operator=(HandleGuard&&) = delete;
+
+        // 允许移动构造
+        HandleGuard(HandleGuard&& other) noexcept
+            : cache(other.cache), slot(other.slot)
+        {
+            other.cache = nullptr;
+            other.slot = nullptr;
+        }
+
+        // 显式释放资源
+        void reset() {
+            if (valid()) {
+                cache->unref(slot);
+                cache = nullptr;
+                slot = nullptr;
+            }
+        }
+
+        VALUE& value() const {
+            assert(valid());
+            return *slot->value;
+        }
+
+        const KEY& key() const {
+            assert(valid());
+            return *slot->key;
+        }
+
+        bool valid() const {
+            return cache && slot;
+        }
+
+        explicit operator bool() const { return valid(); }
+
+    private:
+        HandleGuard() : cache(nullptr), slot(nullptr) {}
+        // 引用计数已由 ClockCache 加好
+        HandleGuard(ClockCache* cache, Slot* slot) : cache(cache), slot(slot) {}
+        friend class ClockCache;
+        ClockCache* cache;
+        Slot* slot;
+    };
+
+public:
+    // 构造函数：按 max_size 预分配槽位（槽位数 >= 2 * max_size，取 2 的幂）
+    explicit ClockCache(size_t max_size)
+        : max_size(max_size), size(0), mask(0), clock_hand(0)
+    {
+        assert(max_size > 0);
+        size_t num_slots = 1;
+        while (num_slots < max_size * 2) {
+            num_slots <<= 1;
+        }
+        mask = num_slots - 1;
+        slots.reset(new Slot[num_slots]);
+    }
+
+    // 析构函数：确保所有资源被安全释放
+    ~ClockCache()
+    {
+        prune();
+        // 如果外部仍在使用 ClockCache，则报错
+        assert(size.load() == 0);
+    }
+
+    // Disable copy and move
+    ClockCache(const ClockCache&) = delete;
+    ClockCache& operator=(const ClockCache&) = delete;
+    ClockCache(ClockCache&&) = delete;
+    ClockCache& operator=(ClockCache&&) = delete;
+
+    // 调整最大容量，不能超过构造时槽位数的一半
+    void set_max_size(size_t max_size)
+    {
+        assert(max_size > 0 && max_size * 2 <= mask + 1);
+        std::lock_guard<std::mutex> lock(mutex);
+        this->max_size = max_size;
+        evict_if_needed(0);
+    }
+
+    size_t get_max_size() const { return max_size; }
+    size_t get_size() const { return size.load(std::memory_order_relaxed); }
+
+    // 清除所有未被引用的缓存
+    void prune()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i <= mask; i++) {
+            Slot* slot = &slots[i];
+            uint64_t meta = slot->meta.load(std::memory_order_acquire);
+            if ((meta & kStateMask) == kVisible && (meta & kRefMask) == 0) {
+                try_evict(slot, meta);
+            }
+        }
+    }
+
+    // 获取缓存项：无锁，命中只增加引用计数并置访问位
+    HandleGuard get(const KEY& key)
+    {
+        Slot* slot = lookup(key, hasher(key));
+        return slot ? HandleGuard(this, slot) : HandleGuard();
+    }
+
+    // 插入缓存项；所有槽位都被占用且无法淘汰时返回无效句柄
+    template<typename V>
+    HandleGuard put(const KEY& key, V&& value)
+    {
+        static_assert(std::is_constructible_v<VALUE, V&&>, "value 必须用来构造 VALUE");
+        uint64_t hash = hasher(key);
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Slot* old_slot = lookup(key, hash, /*locked=*/true);
+        evict_if_needed(old_slot ? 0 : 1);
+        Slot* slot = insert(key, hash, std::forward<V>(value));
+        if (old_slot) {
+            // 新值已可见，再移出旧槽位；插入失败时保留旧值
+            if (slot) {
+                erase(old_slot);
+            }
+            unref(old_slot, /*locked=*/true);
+        }
+        return slot ? HandleGuard(this, slot) : HandleGuard();
+    }
+
+    // 删除缓存项（从缓存中移除，被引用的槽位在最后一个句柄释放时回收）
+    bool del(const KEY& key)
+    {
+        uint64_t hash = hasher(key);
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot* slot = lookup(key, hash, /*locked=*/true);
+        if (!slot) {
+            return false;
+        }
+        erase(slot);
+        unref(slot, /*locked=*/true);
+        return true;
+    }
+
+private:
+    static uint64_t state_of(uint64_t meta) { return meta & kStateMask; }
+    static uint64_t ref_of(uint64_t meta) { return meta & kRefMask; }
+
+    size_t home_of(uint64_t hash) const {
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    // 无锁查找：命中时返回已加过引用的槽位；locked 表示调用方已持有写锁
+    Slot* lookup(const KEY& key, uint64_t hash, bool locked = false)
+    {
+        size_t pos = home_of(hash);
+        for (size_t i = 0; i <= mask; i++, pos = (pos + 1) & mask) {
+            Slot* slot = &slots[pos];
+            uint64_t meta = slot->meta.load(std::memory_order_acquire);
+            if (state_of(meta) == kVisible) {
+                meta = slot->meta.fetch_add(1, std::memory_order_acq_rel);
+                // 加引用后状态仍为 VISIBLE，槽位内容在释放引用前不会被写者改动
+                if (state_of(meta) == kVisible && slot->hash == hash && *slot->key == key) {
+                    if (!(meta & kAccessBit)) {
+                        slot->meta.fetch_or(kAccessBit, std::memory_order_relaxed);
+                    }
+                    return slot;
+                }
+                unref(slot, locked);
+            }
+            if (slot->displacements.load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    // 插入新槽位（调用方需持锁），返回已加一次引用的槽位
+    template<typename V>
+    Slot* insert(const KEY& key, uint64_t hash, V&& value)
+    {
+        size_t home = home_of(hash);
+        size_t pos = home;
+        for (size_t i = 0; i <= mask; i++, pos = (pos + 1) & mask) {
+            Slot* slot = &slots[pos];
+            uint64_t expected = kEmpty;
+            if (slot->meta.compare_exchange_strong(expected, kConstruction, std::memory_order_acq_rel)) {
+                slot->hash = hash;
+                slot->key.emplace(key);
+                slot->value.emplace(std::forward<V>(value));
+                // 发布：CONSTRUCTION -> VISIBLE，并为调用方加一次引用
+                slot->meta.fetch_add(kVisible - kConstruction + 1, std::memory_order_release);
+                size.fetch_add(1, std::memory_order_relaxed);
+                return slot;
+            }
+            slot->displacements.fetch_add(1, std::memory_order_release);
+        }
+        // 表已满：撤销沿途的 displacements
+        rollback_displacements(home, pos);
+        return nullptr;
+    }
+
+    void rollback_displacements(size_t from, size_t to)
+    {
+        for (size_t pos = from; pos != to; pos = (pos + 1) & mask) {
+            slots[pos].displacements.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // 移出缓存（调用方需持锁且持有该槽位的引用）：VISIBLE -> INVISIBLE
+    void erase(Slot* slot)
+    {
+        uint64_t meta = slot->meta.load(std::memory_order_acquire);
+        while (state_of(meta) == kVisible) {
+            if (slot->meta.compare_exchange_weak(meta, (meta & ~kStateMask) | kInvisible,
+                                                 std::memory_order_acq_rel)) {
+                size.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    // 释放引用：INVISIBLE 的最后一个引用负责回收槽位
+    void unref(Slot* slot, bool locked = false)
+    {
+        uint64_t meta = slot->meta.fetch_sub(1, std::memory_order_acq_rel);
+        assert(ref_of(meta) > 0);
+        if (state_of(meta) == kInvisible && ref_of(meta) == 1) {
+            if (locked) {
+                reclaim_invisible(slot);
+            } else {
+                std::lock_guard<std::mutex> lock(mutex);
+                reclaim_invisible(slot);
+            }
+        }
+    }
+
+    // 回收无引用的 INVISIBLE 槽位（调用方需持锁）；存在读者的临时引用时由该读者释放时回收
+    void reclaim_invisible(Slot* slot)
+    {
+        uint64_t meta = slot->meta.load(std::memory_order_acquire);
+        if (state_of(meta) == kInvisible && ref_of(meta) == 0 &&
+            slot->meta.compare_exchange_strong(meta, kConstruction, std::memory_order_acq_rel)) {
+            free_slot(slot);
+        }
+    }
+
+    // 淘汰无引用的 VISIBLE 槽位（调用方需持锁）
+    bool try_evict(Slot* slot, uint64_t meta)
+    {
+        if (slot->meta.compare_exchange_strong(meta, kConstruction, std::memory_order_acq_rel)) {
+            size.fetch_sub(1, std::memory_order_relaxed);
+            free_slot(slot);
+            return true;
+        }
+        return false;
+    }
+
+    // 清理 CONSTRUCTION 状态的槽位并归还：CONSTRUCTION -> EMPTY（保留读者的临时引用）
+    void free_slot(Slot* slot)
+    {
+        value_deleter(*slot->value);
+        slot->value.reset();
+        slot->key.reset();
+        rollback_displacements(home_of(slot->hash), static_cast<size_t>(slot - slots.get()));
+        slot->meta.fetch_sub(kConstruction, std::memory_order_release);
+    }
+
+    // CLOCK 淘汰（调用方需持锁）：为即将插入的 incoming 个条目腾出空间
+    // 指针最多转两圈：第一圈清访问位，第二圈淘汰；全部被引用时放弃
+    void evict_if_needed(size_t incoming)
+    {
+        size_t budget = 2 * (mask + 1);
+        while (size.load(std::memory_order_relaxed) + incoming > max_size && budget-- > 0) {
+            Slot* slot = &slots[clock_hand];
+            clock_hand = (clock_hand + 1) & mask;
+            uint64_t meta = slot->meta.load(std::memory_order_acquire);
+            if (state_of(meta) != kVisible || ref_of(meta) != 0) {
+                continue;
+            }
+            if (meta & kAccessBit) {
+                slot->meta.fetch_and(~kAccessBit, std::memory_order_relaxed);
+                continue;
+            }
+            try_evict(slot, meta);
+        }
+    }
+
+    size_t max_size;
+    std::atomic<size_t> size;       // VISIBLE 槽位数
+    size_t mask;
+    size_t clock_hand;              // CLOCK 指针（持锁访问）
+    std::unique_ptr<Slot[]> slots;
+    Hash hasher;
+    ValueDeleter value_deleter;
+    std::mutex mutex;               // 只保护写路径
+};
@@ -0,0 +1,139 @@
+// EvictionPolicy.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LRUCache 的淘汰策略（编译期通过模板参数选择）
+// 策略只负责决策，not_use / in_use / to_del 的维护仍由 LRUCache 完成：
+// 1. kSegmented：是否把未被引用的节点分成 probation（试用）/ protected（保护）两段
+// 2. kAdmission：缓存满时是否由 admit() 决定新条目能否挤掉淘汰候选
+// 3. record_access()：每次 get / put 时回调，用于统计访问频率
+
+// 经典 LRU：所有节点在一条 not_use 队列中，无准入过滤（默认）
+struct LRUPolicy {
+    static constexpr bool kSegmented = false;
+    static constexpr bool kAdmission = false;
+
+    void set_capacity(size_t) {}
+    size_t protected_capacity(size_t) const { return 0; }
+    void record_access(size_t) {}
+    bool admit(size_t, size_t) { return true; }
+};
+
+// 分段 LRU（SLRU）：新条目进入 probation，再次命中才晋升 protected
+// protected 超出配额时，最久未使用的节点降级回 probation 尾部；淘汰优先从 probation 头部开始
+// 一次性扫描只会冲刷 probation，热点数据留在 protected 中
+struct SLRUPolicy {
+    static constexpr bool kSegmented = true;
+    static constexpr bool kAdmission = false;
+
+    void set_capacity(size_t) {}
+    // protected 段占总容量的 80%
+    size_t protected_capacity(size_t capacity) const { return capacity - capacity / 5; }
+    void record_access(size_t) {}
+    bool admit(size_t, size_t) { return true; }
+};
+
+// Count-Min Sketch：4 行 4bit 计数器，估计 key 的近期访问频率
+// 累计增加 10 * width 次后所有计数器减半（老化），让频率反映近期热度
+class CountMinSketch {
+public:
+    CountMinSketch() { resize(1024); }
+
+    // width 取不小于 n 的 2 的幂，每行 width 个计数器
+    void resize(size_t n)
+    {
+        size_t width = 64;
+        while (width < n) {
+            width <<= 1;
+        }
+        mask = width - 1;
+        table.assign(kDepth * width / kCountersPerWord, 0);
+        sample_size = 10 * width;
+        additions = 0;
+    }
+
+    void increment(size_t hash)
+    {
+        bool added = false;
+        for (size_t i = 0; i < kDepth; i++) {
+            size_t index = index_of(hash, i);
+            uint64_t& word = table[index / kCountersPerWord];
+            size_t shift = (index % kCountersPerWord) * 4;
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions >= sample_size) {
+            reset();
+        }
+    }
+
+    // 取各行计数的最小值作为频率估计
+    uint32_t frequency(size_t hash) const
+    {
+        uint32_t freq = 0xF;
+        for (size_t i = 0; i < kDepth; i++) {
+            size_t index = index_of(hash, i);
+            uint64_t word = table[index / kCountersPerWord];
+            uint32_t count = static_cast<uint32_t>((word >> ((index % kCountersPerWord) * 4)) & 0xF);
+            freq = count < freq ? count : freq;
+        }
+        return freq;
+    }
+
+private:
+    static constexpr size_t kDepth = 4;
+    static constexpr size_t kCountersPerWord = 16;
+
+    // 每行使用不同种子重新打散哈希，映射到该行的计数器
+    size_t index_of(size_t hash, size_t row) const
+    {
+        static constexpr uint64_t kSeeds[kDepth] = {
+            0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull,
+            0x9ae16a3b2f90404full, 0xcbf29ce484222325ull};
+        uint64_t h = (static_cast<uint64_t>(hash) + kSeeds[row]) * kSeeds[row];
+        h ^= h >> 32;
+        return row * (mask + 1) + static_cast<size_t>(h & mask);
+    }
+
+    // 老化：所有计数器减半
+    void reset()
+    {
+        for (uint64_t& word : table) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        additions /= 2;
+    }
+
+    std::vector<uint64_t> table;
+    size_t mask = 0;
+    size_t sample_size = 0;
+    size_t additions = 0;
+};
+
+// TinyLFU 准入：缓存已满时，新条目的估计频率必须高于淘汰候选才允许插入
+// 主缓存默认使用 SLRU 分段；被拒绝的条目仍通过句柄返回给调用方，只是不进入缓存
+template<class Segments = SLRUPolicy>
+struct TinyLFUPolicy : Segments {
+    static constexpr bool kAdmission = true;
+
+    // 按容量确定 sketch 宽度（上限 2^20 个计数器，避免按字节计容量时过大）
+    void set_capacity(size_t capacity)
+    {
+        Segments::set_capacity(capacity);
+        size_t width = capacity == 0 ? 1024 : capacity;
+        sketch.resize(width < (size_t(1) << 20) ? width : (size_t(1) << 20));
+    }
+
+    void record_access(size_t hash) { sketch.increment(hash); }
+
+    bool admit(size_t candidate, size_t victim)
+    {
+        return sketch.frequency(candidate) > sketch.frequency(victim);
+    }
+
+    CountMinSketch sketch;
+};
@@ -1,11 +1,20 @@
 // lrucache.h
 #pragma once
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <list>
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
+#include <vector>
+#include "CacheSnapshot.h"
+#include "CacheStats.h"
+#include "EvictionPolicy.h"
 
 // 默认删除器：自动处理指针类型（调用 delete）和非指针类型（无操作）
 template<typename T>
@@ -19,12 +28,29 @@ struct DefaultValueDeleter {
     }
 };
 
+// 空锁：单线程使用时不引入任何同步开销（默认）
+struct NullMutex {
+    void lock() {}
+    void unlock() {}
+};
+
 // LRUCache 实现：基于双列表的引用计数 LRU 缓存
 // 核心设计：
 // 1. not_use 列表维护 LRU 顺序（头部 = 最久未使用）（ref == 1)
 // 2. in_use 列表存储外部正在使用的节点（ref > 1）
 // 3. to_del 列表存储已移出缓存但外部仍引用的节点（由 HandleGuard 清理）
-template<typename KEY, typename VALUE, class ValueDeleter = DefaultValueDeleter<VALUE>>
+// 4. Mutex 默认为 NullMutex；传入 std::mutex 时所有公开接口及 HandleGuard 释放均加锁
+// 5. 容量按 charge 计：每个条目插入时指定 charge（默认 1，即按条目数计），淘汰按 charge 总和判断
+// 6. Policy 决定淘汰策略（见 EvictionPolicy.h）：分段策略下未被引用的节点分布在
+//    not_use（probation）和 protected_list（protected）两条队列中，准入策略可拒绝新条目
+// 7. TTL：带过期时间的节点挂在一个哈希时间轮上（思路同 Timer 的有序定时器，但按槽位散列，插入/删除 O(1)）
+//    get 遇到过期节点按未命中处理并顺带移除；expire() 按预算逐槽推进清理，put 时也会顺带清理少量节点
+// 8. 快照（见 CacheSnapshot.h）：save_snapshot 按从新到旧写出缓存内容，load_snapshot 用 mmap 读回，
+//    恢复的条目整批放入 probation 头部，最后只做一次淘汰检查，用于重启后快速预热
+// 9. 统计（见 CacheStats.h）：编译期开关，计数在锁内累加，关闭时不产生任何额外开销
+// 10. Hash 为 cache_map 使用的哈希函数，准入策略的频率统计也用它
+template<typename KEY, typename VALUE, class ValueDeleter = DefaultValueDeleter<VALUE>,
+         class Mutex = NullMutex, class Policy = LRUPolicy, class Hash = std::hash<KEY>>
 class LRUCache {
 private:
     // 缓存节点结构
@@ -33,14 +59,22 @@ private:
         KEY key;
         int ref;            // 引用计数（外部持有 + 缓存自身）
         bool in_cache;      // 是否在缓存中（用于状态判断）
+        bool in_protected;  // 是否属于 protected 段（仅分段策略使用）
+        size_t charge;      // 占用的容量（如字节数）
+        uint64_t expire_at; // 过期时间（毫秒 tick），0 表示永不过期
+        uint32_t wheel_slot;    // 所在时间轮槽位
+        Node* wheel_prev;       // 时间轮槽位内的双向链表
+        Node* wheel_next;
         
         typename std::list<Node>::iterator list_pos;    // 指向当前节点在哪个列表
         
-        Node(const KEY& k, VALUE&& v) 
-            : value(std::move(v)), key(k), in_cache(false), ref(1) {}
+        Node(const KEY& k, VALUE&& v, size_t c) 
+            : value(std::move(v)), key(k), ref(1), in_cache(false), in_protected(false), charge(c),
+              expire_at(0), wheel_slot(0), wheel_prev(nullptr), wheel_next(nullptr) {}
             
-        Node(const KEY& k, const VALUE& v) 
-            : value(v), key(k), in_cache(false), ref(1) {}
+        Node(const KEY& k, const VALUE& v, size_t c) 
+            : value(v), key(k), ref(1), in_cache(false), in_protected(false), charge(c),
+              expire_at(0), wheel_slot(0), wheel_prev(nullptr), wheel_next(nullptr) {}
     };
 
     typedef typename std::list<Node>::iterator ListNodeIterator;
@@ -63,6 +97,9 @@ public:
         HandleGuard(HandleGuard&& other) noexcept
             : cache(other.cache), node(other.node) 
         {
+#ifdef LRU_CACHE_STATS
+            acquired_ns = other.acquired_ns;
+#endif
             other.cache = nullptr;
             other.node = nullptr;
         }
@@ -70,7 +107,11 @@ public:
         // 显式释放资源
         void reset() {
             if (valid()) {
-                cache->unref_node(node);
+#ifdef LRU_CACHE_STATS
+                cache->release(node, cache_now_ns() - acquired_ns);
+#else
+                cache->release(node, 0);
+#endif
                 cache = nullptr;
                 node = nullptr;
             }
@@ -91,10 +132,19 @@ public:
         }
         
         explicit operator bool() const { return valid(); }
+
+        // 再获取一个指向同一节点的句柄（引用计数 +1）
+        HandleGuard clone() const {
+            if (!valid()) {
+                return HandleGuard();
+            }
+            std::lock_guard<Mutex> lock(cache->mutex);
+            return HandleGuard(cache, node);
+        }
         
     private:
         HandleGuard() : cache(nullptr), node(nullptr) {}
-        // 只允许 
+        // 只允许 LRUCache 在持锁状态下构造
         explicit HandleGuard(LRUCache* cache, Node* node)
             : cache(cache), node(node) 
         {
@@ -102,14 +152,21 @@ public:
                 cache->ref_node(node);
             }
         }
-        friend class LRUCache<KEY, VALUE, ValueDeleter>;
+        friend class LRUCache;
         LRUCache* cache;
         Node* node;
+#ifdef LRU_CACHE_STATS
+        uint64_t acquired_ns = cache_now_ns();  // 句柄获取时间，用于统计持有时长
+#endif
     };
 
 public:
     // 构造函数：初始化缓存
-    LRUCache() : max_size(0), size(0) {}
+    LRUCache() : max_size(0), size(0), usage(0), pinned_usage(0), protected_usage(0),
+                 wheel_tick(0), sweeping(false), sweep_cursor(nullptr)
+    {
+        policy.set_capacity(0);
+    }
     
     // 析构函数：确保所有资源被安全释放
     ~LRUCache()
@@ -127,115 +184,431 @@ public:
     LRUCache(LRUCache&&) = delete;
     LRUCache& operator=(LRUCache&&) = delete;
     
-    // 设置最大容量，0表示无限制
+    // 设置最大容量（charge 总和上限），0表示无限制
     void set_max_size(size_t max_size)
     {
+        std::lock_guard<Mutex> lock(mutex);
         this->max_size = max_size;
+        policy.set_capacity(max_size);
+        balance_protected();
         evict_if_needed();
     }
     
     size_t get_max_size() const { return max_size; }
-    size_t get_size() const { return size; }
+    size_t get_size() const
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        return size;
+    }
+
+    // 缓存中条目（not_use + in_use）的 charge 总和
+    size_t get_usage() const
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        return usage;
+    }
+
+    // 被外部引用条目（in_use + to_del）的 charge 总和
+    size_t get_pinned_usage() const
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        return pinned_usage;
+    }
+
+    // 统计快照（未开启 LRU_CACHE_STATS 时计数均为 0，仅填充 size / usage / pinned_usage）
+    CacheStats get_stats() const
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        CacheStats snapshot = stats;
+        snapshot.size = size;
+        snapshot.usage = usage;
+        snapshot.pinned_usage = pinned_usage;
+        return snapshot;
+    }
+
+    void reset_stats()
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        stats = CacheStats();
+    }
     
     // 清除所有未被使用的缓存
     void prune()
     {
-        for (auto it = not_use.begin(); it != not_use.end(); ) {
-            Node& node = *it;
-            
-            // 从 map 中移除
-            cache_map.erase(node.key);
-            
-            // 清理节点
-            node.in_cache = false;
-            value_deleter(node.value);
-            
-            // erase 返回下一个有效迭代器
-            it = not_use.erase(it);
-            size--;
+        std::lock_guard<Mutex> lock(mutex);
+        while (!not_use.empty()) {
+            evict_node(not_use, not_use.begin());
+        }
+        while (!protected_list.empty()) {
+            evict_node(protected_list, protected_list.begin());
         }
     }
     
     // 获取缓存项
     HandleGuard get(const KEY& key)
     {
+        LatencyTimer timer;
+        std::lock_guard<Mutex> lock(mutex);
+        HandleGuard handle = get_locked(key);
+        timer.record_to(stats.get_latency);
+        return handle;
+    }
+    
+    // 插入缓存项，charge 为该条目占用的容量
+    template<typename V>
+    HandleGuard put(const KEY& key, V&& value, size_t charge = 1)
+    {
+        static_assert(std::is_constructible_v<VALUE, V&&>, "value 必须用来构造 VALUE");
+        LatencyTimer timer;
+        std::lock_guard<Mutex> lock(mutex);
+        HandleGuard handle = put_locked(key, std::forward<V>(value), charge, 0);
+        timer.record_to(stats.put_latency);
+        return handle;
+    }
+
+    // 插入带 TTL 的缓存项，ttl 到期后视为未命中
+    template<typename V, typename Rep, typename Period>
+    HandleGuard put(const KEY& key, V&& value, std::chrono::duration<Rep, Period> ttl, size_t charge = 1)
+    {
+        static_assert(std::is_constructible_v<VALUE, V&&>, "value 必须用来构造 VALUE");
+        uint64_t ttl_ms = std::chrono::duration_cast<std::chrono::milliseconds>(ttl).count();
+        LatencyTimer timer;
+        std::lock_guard<Mutex> lock(mutex);
+        HandleGuard handle = put_locked(key, std::forward<V>(value), charge, now_ms() + ttl_ms);
+        timer.record_to(stats.put_latency);
+        return handle;
+    }
+
+    // 批量获取：整批只加一次锁，结果与 keys 一一对应（未命中为无效句柄）
+    std::vector<HandleGuard> multi_get(const KEY* keys, size_t count)
+    {
+        return multi_get_by([keys](size_t i) -> const KEY& { return keys[i]; }, count);
+    }
+
+    std::vector<HandleGuard> multi_get(const std::vector<KEY>& keys)
+    {
+        return multi_get(keys.data(), keys.size());
+    }
+
+    // 批量插入：整批只加一次锁，charges 为空时每个条目 charge 为 1
+    std::vector<HandleGuard> multi_put(const KEY* keys, const VALUE* values, size_t count,
+                                       const size_t* charges = nullptr)
+    {
+        return multi_put_by([keys](size_t i) -> const KEY& { return keys[i]; },
+                            [values](size_t i) -> const VALUE& { return values[i]; },
+                            [charges](size_t i) { return charges ? charges[i] : size_t(1); },
+                            count);
+    }
+
+    // 删除缓存项（从缓存中移除，不释放内存）
+    bool del(const KEY& key)
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        auto it = cache_map.find(key);
+        if (it != cache_map.end()) {
+            erase_locked(it->second);
+            if constexpr (kCacheStatsEnabled) {
+                stats.deletes++;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // 增量清理过期节点：最多检查 max_visits 个时间轮上的节点，返回移除的数量
+    size_t expire(size_t max_visits = 64)
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        return expire_locked(now_ms(), max_visits);
+    }
+
+    // 将缓存内容按从新到旧（in_use -> protected -> probation）写入快照文件，已过期的节点不写入
+    // 序列化在锁内完成，写文件在锁外进行
+    template<class KeySerializer = CacheSerializer<KEY>, class ValueSerializer = CacheSerializer<VALUE>>
+    bool save_snapshot(const std::string& path) const
+    {
+        std::string data;
+        {
+            std::lock_guard<Mutex> lock(mutex);
+            SnapshotHeader header{};
+            std::memcpy(header.magic, SnapshotHeader::kMagic, sizeof(header.magic));
+            header.version = SnapshotHeader::kVersion;
+            data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            uint64_t now = now_ms();
+            uint64_t count = 0;
+            auto write_list = [&](const std::list<Node>& list) {
+                for (auto it = list.rbegin(); it != list.rend(); ++it) {
+                    if (it->expire_at != 0 && it->expire_at <= now) {
+                        continue;
+                    }
+                    CacheSerializer<uint64_t>::write(data, it->charge);
+                    CacheSerializer<uint64_t>::write(data, it->expire_at == 0 ? 0 : it->expire_at - now);
+                    KeySerializer::write(data, it->key);
+                    ValueSerializer::write(data, it->value);
+                    count++;
+                }
+            };
+            write_list(in_use);
+            write_list(protected_list);
+            write_list(not_use);
+            std::memcpy(&data[offsetof(SnapshotHeader, count)], &count, sizeof(count));
+        }
+        return write_snapshot_file(path, data);
+    }
+
+    // 从快照文件恢复，返回恢复的条目数；文件不存在或格式错误时返回 0 且不修改缓存
+    // 1. mmap 文件后在锁外按从新到旧解析，已解析的 charge 达到容量上限即停止
+    // 2. 恢复的条目比缓存中现有条目更旧，整批拼接到 probation 头部；已在缓存中的 key 保留现有值
+    // 3. 合并完成后只调用一次 evict_if_needed，而不是每插入一条检查一次
+    // KEY / VALUE 需可默认构造
+    template<class KeySerializer = CacheSerializer<KEY>, class ValueSerializer = CacheSerializer<VALUE>>
+    size_t load_snapshot(const std::string& path)
+    {
+        MappedFile file;
+        if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) {
+            return 0;
+        }
+        SnapshotHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, SnapshotHeader::kMagic, sizeof(header.magic)) != 0 ||
+            header.version != SnapshotHeader::kVersion) {
+            return 0;
+        }
+
+        // restored 头部为最旧的条目；解析期间 expire_at 暂存剩余 TTL
+        std::list<Node> restored;
+        size_t budget = get_max_size();
+        size_t restored_charge = 0;
+        const char* pos = file.data() + sizeof(header);
+        const char* end = file.data() + file.size();
+        for (uint64_t i = 0; i < header.count; i++) {
+            uint64_t charge = 0;
+            uint64_t ttl_ms = 0;
+            KEY key{};
+            VALUE value{};
+            if (!CacheSerializer<uint64_t>::read(pos, end, charge) ||
+                !CacheSerializer<uint64_t>::read(pos, end, ttl_ms) ||
+                !KeySerializer::read(pos, end, key) ||
+                !ValueSerializer::read(pos, end, value)) {
+                for (Node& node : restored) {
+                    value_deleter(node.value);
+                }
+                return 0;
+            }
+            if (budget > 0 && restored_charge + charge > budget) {
+                value_deleter(value);
+                break;
+            }
+            restored_charge += charge;
+            ListNodeIterator node_iter = restored.emplace(restored.begin(), key, std::move(value), charge);
+            node_iter->expire_at = ttl_ms;
+        }
+
+        std::lock_guard<Mutex> lock(mutex);
+        uint64_t now = now_ms();
+        size_t count = 0;
+        for (ListNodeIterator node_iter = restored.begin(); node_iter != restored.end();) {
+            if (cache_map.count(node_iter->key)) {
+                value_deleter(node_iter->value);
+                node_iter = restored.erase(node_iter);
+                continue;
+            }
+            uint64_t ttl_ms = node_iter->expire_at;
+            node_iter->in_cache = true;
+            node_iter->ref = 1;  // 1 for cache
+            node_iter->list_pos = node_iter;
+            cache_map[node_iter->key] = node_iter;
+            size++;
+            usage += node_iter->charge;
+            wheel_link(&(*node_iter), ttl_ms == 0 ? 0 : now + ttl_ms);
+            ++node_iter;
+            count++;
+        }
+        // splice 不会使 list_pos 失效
+        not_use.splice(not_use.begin(), restored);
+        evict_if_needed();
+        return count;
+    }
+
+    // 当前时间（毫秒 tick，与 Timer::GetTick 同源于 steady_clock）
+    static uint64_t now_ms()
+    {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    template<typename, typename, class, class, class>
+    friend class ShardedLRUCache;
+
+    // 按下标取 key 的批量获取，供 ShardedLRUCache 按分片挑选 key 而无需拷贝
+    template<class KeyAt>
+    std::vector<HandleGuard> multi_get_by(KeyAt&& key_at, size_t count)
+    {
+        std::vector<HandleGuard> handles;
+        handles.reserve(count);
+        std::lock_guard<Mutex> lock(mutex);
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(get_locked(key_at(i)));
+        }
+        return handles;
+    }
+
+    template<class KeyAt, class ValueAt, class ChargeAt>
+    std::vector<HandleGuard> multi_put_by(KeyAt&& key_at, ValueAt&& value_at, ChargeAt&& charge_at,
+                                          size_t count)
+    {
+        std::vector<HandleGuard> handles;
+        handles.reserve(count);
+        std::lock_guard<Mutex> lock(mutex);
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(put_locked(key_at(i), value_at(i), charge_at(i), 0));
+        }
+        return handles;
+    }
+
+    // 将节点移出缓存（调用方需持锁）
+    void erase_locked(ListNodeIterator node_iter)
+    {
+        // 从映射中移除
+        cache_map.erase(node_iter->key);
+        wheel_unlink(&(*node_iter));
+        size--;
+        usage -= node_iter->charge;
+        if (node_iter->in_protected) {
+            protected_usage -= node_iter->charge;
+        }
+        
+        // 从适当的链表中移除
+        if (node_iter->ref == 1) {
+            // 仅缓存持有：直接从 not_use / protected_list 移除并清理
+            value_deleter(node_iter->value);
+            lru_list_of(&(*node_iter)).erase(node_iter);
+        } else {
+            // 外部持有：移入 to_del（由 HandleGuard 清理），仍计入 pinned_usage
+            to_del.splice(to_del.end(), in_use, node_iter);
+            node_iter->in_cache = false;
+            node_iter->in_protected = false;
+            node_iter->ref--;   // 释放缓存引用
+        }
+    }
+
+    // 获取缓存项（调用方需持锁）
+    HandleGuard get_locked(const KEY& key)
+    {
+        record_access(key);
         auto it = cache_map.find(key);
         if (it != cache_map.end()) {
             // 节点在缓存中，返回句柄（自动增加引用计数）
-            return HandleGuard(this, &(*it->second));
+            Node* node = &(*it->second);
+            if (node->expire_at != 0 && node->expire_at <= now_ms()) {
+                // 已过期：按未命中处理并顺带移除
+                erase_locked(it->second);
+                if constexpr (kCacheStatsEnabled) {
+                    stats.expirations++;
+                    stats.misses++;
+                }
+                return HandleGuard();
+            }
+            promote(node);
+            if constexpr (kCacheStatsEnabled) {
+                stats.hits++;
+            }
+            return HandleGuard(this, node);
+        }
+        if constexpr (kCacheStatsEnabled) {
+            stats.misses++;
         }
         return HandleGuard();
     }
     
-    // 插入缓存项
+    // 插入缓存项（调用方需持锁），expire_at 为 0 表示永不过期
     template<typename V>
-    HandleGuard put(const KEY& key, V&& value)
+    HandleGuard put_locked(const KEY& key, V&& value, size_t charge, uint64_t expire_at)
     {
-        static_assert(std::is_constructible_v<VALUE, V&&>, "value 必须用来构造 VALUE");
+        if (!wheel.empty()) {
+            // 顺带推进时间轮，避免完全依赖外部调用 expire()
+            expire_locked(now_ms(), kPutSweepVisits);
+        }
+        record_access(key);
         auto it = cache_map.find(key);
         
+        bool updated = false;
+        bool in_protected = false;
         if (it != cache_map.end()) {
-            // 键已存在，更新值
-            ListNodeIterator node_iter = it->second;
-            node_iter->value = std::forward<V>(value);
+            // 键已存在：新值放入新节点，旧节点移出缓存（无人引用时立即清理，否则进入 to_del）
+            // 不能原地赋值：其他线程可能正持有旧节点的句柄，在锁外读取 value
+            updated = true;
+            in_protected = it->second->in_protected;
+            erase_locked(it->second);
+        } else if (!admit(key, charge)) {
+            // 准入过滤：缓存已满且新条目不比淘汰候选更热时，不进入缓存
+            // 节点直接放入 to_del，由返回的句柄释放时清理
+            ListNodeIterator node_iter = to_del.emplace(to_del.end(), key, std::forward<V>(value), charge);
+            node_iter->ref = 0;
+            node_iter->list_pos = node_iter;
+            pinned_usage += charge;
+            if constexpr (kCacheStatsEnabled) {
+                stats.rejections++;
+            }
             return HandleGuard(this, &(*node_iter));
         }
-        
-        // 创建新节点，直接放在 in_use 中（因为调用者有引用）
-        ListNodeIterator node_iter = not_use.emplace(not_use.end(), key, std::forward<V>(value));
+
+        // 创建新节点，放在 not_use（probation）尾部（更新 protected 段中的条目时仍留在 protected 段），
+        // 随后由返回的句柄移入 in_use
+        std::list<Node>& list = in_protected ? protected_list : not_use;
+        ListNodeIterator node_iter = list.emplace(list.end(), key, std::forward<V>(value), charge);
         
         node_iter->in_cache = true;
+        node_iter->in_protected = in_protected;
         node_iter->ref = 1;  // 1 for cache
         node_iter->list_pos = node_iter;
         
         // 添加到缓存映射
         cache_map[key] = node_iter;
         size++;
+        usage += charge;
+        if (in_protected) {
+            protected_usage += charge;
+        }
+        wheel_link(&(*node_iter), expire_at);
+        if constexpr (kCacheStatsEnabled) {
+            if (updated) {
+                stats.updates++;
+            } else {
+                stats.inserts++;
+            }
+        }
         
-        // 如果需要，进行淘汰
+        // 先持有句柄再淘汰，保证新节点不会被自身的 charge 挤出
+        HandleGuard handle(this, &(*node_iter));
+        balance_protected();
         evict_if_needed();
         
-        return HandleGuard(this, &(*node_iter));
+        return handle;
     }
     
-    // 删除缓存项（从缓存中移除，不释放内存）
-    bool del(const KEY& key)
-    {
-        auto it = cache_map.find(key);
-        if (it != cache_map.end()) {
-            ListNodeIterator node_iter = it->second;
-            // 从映射中移除
-            cache_map.erase(it);
-            
-            // 从适当的链表中移除
-            if (node_iter->ref == 1) {
-                // 仅缓存持有：直接从 not_use 移除并清理
-                value_deleter(node_iter->value);
-                not_use.erase(node_iter);
-            } else {
-                // 外部持有：移入 to_del（由 HandleGuard 清理）
-                to_del.splice(to_del.end(), in_use, node_iter);
-                node_iter->in_cache = false;
-                node_iter->ref--;   // 释放缓存引用
-            }
-            
-            size--;
-            return true;
+    // HandleGuard 释放入口：加锁后减少引用，lifetime_ns 为句柄持有时长（未开启统计时为 0）
+    void release(Node* node, uint64_t lifetime_ns) {
+        std::lock_guard<Mutex> lock(mutex);
+        if constexpr (kCacheStatsEnabled) {
+            stats.record_handle_release(lifetime_ns);
         }
-        return false;
+        unref_node(node);
     }
 
-private:
-    // 增加节点引用
+    // 增加节点引用（调用方需持锁）
     void ref_node(Node* node) {
         if (node->in_cache && node->ref == 1) {
-            // 从 not_use 移入 in_use（表示节点被外部使用）
-            in_use.splice(in_use.end(), not_use, node->list_pos);
+            // 从 not_use / protected_list 移入 in_use（表示节点被外部使用）
+            in_use.splice(in_use.end(), lru_list_of(node), node->list_pos);
+            pinned_usage += node->charge;
         }
         node->ref++;
     }
     
-    // 减少节点引用
+    // 减少节点引用（调用方需持锁）
     void unref_node(Node* node) {
         assert(node->ref > 0);
         node->ref--;
@@ -243,41 +616,233 @@ private:
         if (node->ref == 0) {
             // 无引用：从 to_del 中移除并清理
             assert(!node->in_cache);
+            pinned_usage -= node->charge;
             value_deleter(node->value);
             to_del.erase(node->list_pos);
         } else if (node->in_cache && node->ref == 1) {
-            // 从 in_use 移入 not_use（表示节点可被 LRU 淘汰）
-            not_use.splice(not_use.end(), in_use, node->list_pos);
+            // 从 in_use 移回所属段的尾部（表示节点可被 LRU 淘汰）
+            std::list<Node>& list = lru_list_of(node);
+            list.splice(list.end(), in_use, node->list_pos);
+            pinned_usage -= node->charge;
+            // 被引用期间可能超出容量，释放后补做淘汰
+            balance_protected();
+            evict_if_needed();
         }
     }
     
-    // 淘汰检查
+    // 未被引用的节点所在队列
+    std::list<Node>& lru_list_of(const Node* node) {
+        return node->in_protected ? protected_list : not_use;
+    }
+
+    // 淘汰候选：优先 probation 头部，其次 protected 头部
+    Node* eviction_candidate() {
+        if (!not_use.empty()) {
+            return &not_use.front();
+        }
+        if (!protected_list.empty()) {
+            return &protected_list.front();
+        }
+        return nullptr;
+    }
+
+    void record_access(const KEY& key) {
+        if constexpr (Policy::kAdmission) {
+            policy.record_access(cache_map.hash_function()(key));
+        }
+    }
+
+    // 准入检查：仅在插入会触发淘汰时询问策略
+    bool admit(const KEY& key, size_t charge) {
+        if constexpr (Policy::kAdmission) {
+            if (max_size > 0 && usage + charge > max_size) {
+                Node* victim = eviction_candidate();
+                if (victim) {
+                    auto hash = cache_map.hash_function();
+                    return policy.admit(hash(key), hash(victim->key));
+                }
+            }
+        }
+        return true;
+    }
+
+    // 命中时由 probation 晋升 protected（仅分段策略）
+    void promote(Node* node) {
+        if constexpr (Policy::kSegmented) {
+            if (!node->in_protected) {
+                if (node->ref == 1) {
+                    protected_list.splice(protected_list.end(), not_use, node->list_pos);
+                }
+                node->in_protected = true;
+                protected_usage += node->charge;
+                balance_protected();
+            }
+        }
+    }
+
+    // protected 超出配额时，把最久未使用的节点降级到 probation 尾部
+    void balance_protected() {
+        if constexpr (Policy::kSegmented) {
+            if (max_size == 0) {
+                return;
+            }
+            size_t limit = policy.protected_capacity(max_size);
+            while (protected_usage > limit && !protected_list.empty()) {
+                Node& node = protected_list.front();
+                node.in_protected = false;
+                protected_usage -= node.charge;
+                not_use.splice(not_use.end(), protected_list, node.list_pos);
+            }
+        }
+    }
+
+    // 从 not_use / protected_list 中淘汰一个节点（调用方需持锁）
+    void evict_node(std::list<Node>& list, ListNodeIterator node_iter) {
+        Node& node = *node_iter;
+        
+        // 从映射中移除
+        cache_map.erase(node.key);
+        wheel_unlink(&node);
+        
+        // 清理节点
+        node.in_cache = false;
+        value_deleter(node.value);
+        usage -= node.charge;
+        if (node.in_protected) {
+            protected_usage -= node.charge;
+        }
+        list.erase(node_iter);
+        size--;
+    }
+
+    // 将节点挂到过期时间所在的槽位；不晚于清理进度的节点挂到下一个待清理的槽位
+    // （正在清理的槽位已越过头部，新节点挂在头部会被漏掉，因此要再往后一格）
+    void wheel_link(Node* node, uint64_t expire_at) {
+        node->expire_at = expire_at;
+        if (expire_at == 0) {
+            return;
+        }
+        if (wheel.empty()) {
+            wheel.assign(kWheelSlots, nullptr);
+            wheel_tick = now_ms() / kWheelTickMs;
+        }
+        uint64_t tick = expire_at / kWheelTickMs;
+        uint64_t next_tick = sweeping ? wheel_tick + 1 : wheel_tick;
+        node->wheel_slot = static_cast<uint32_t>((tick > next_tick ? tick : next_tick) % kWheelSlots);
+        Node*& head = wheel[node->wheel_slot];
+        node->wheel_prev = nullptr;
+        node->wheel_next = head;
+        if (head) {
+            head->wheel_prev = node;
+        }
+        head = node;
+    }
+
+    void wheel_unlink(Node* node) {
+        if (node->expire_at == 0) {
+            return;
+        }
+        if (node == sweep_cursor) {
+            sweep_cursor = node->wheel_next;
+        }
+        if (node->wheel_prev) {
+            node->wheel_prev->wheel_next = node->wheel_next;
+        } else {
+            wheel[node->wheel_slot] = node->wheel_next;
+        }
+        if (node->wheel_next) {
+            node->wheel_next->wheel_prev = node->wheel_prev;
+        }
+        node->wheel_prev = node->wheel_next = nullptr;
+        node->expire_at = 0;
+    }
+
+    // 从清理进度逐槽推进到当前 tick 之前（只清理已完整流逝的 tick，槽内本轮节点必然都已过期），
+    // 每推进一个槽位或检查一个节点消耗一次预算
+    // 槽位中未到期的节点属于后续轮次，跳过即可；预算耗尽时记住槽内位置，下次从该处继续
+    size_t expire_locked(uint64_t now, size_t max_visits) {
+        if (wheel.empty()) {
+            return 0;
+        }
+        size_t removed = 0;
+        uint64_t now_tick = now / kWheelTickMs;
+        while (max_visits > 0) {
+            if (!sweeping) {
+                if (wheel_tick >= now_tick) {
+                    break;
+                }
+                // 落后超过一整圈时，只需再完整扫一圈
+                if (now_tick - wheel_tick > kWheelSlots) {
+                    wheel_tick = now_tick - kWheelSlots;
+                }
+                sweep_cursor = wheel[wheel_tick % kWheelSlots];
+                sweeping = true;
+                max_visits--;
+            }
+            while (sweep_cursor && max_visits > 0) {
+                Node* node = sweep_cursor;
+                sweep_cursor = node->wheel_next;
+                max_visits--;
+                if (node->expire_at <= now) {
+                    erase_locked(node->list_pos);
+                    removed++;
+                }
+            }
+            if (sweep_cursor) {
+                break;
+            }
+            sweeping = false;
+            wheel_tick++;
+        }
+        if constexpr (kCacheStatsEnabled) {
+            stats.expirations += removed;
+        }
+        return removed;
+    }
+
+    // 淘汰检查：charge 总和超过容量时从 probation 头部开始淘汰
     void evict_if_needed() {
         if (max_size > 0) {
-            while (size > max_size && !not_use.empty()) {
-                auto node_iter = not_use.begin();
-                Node& node = *node_iter;
-                
-                // 从映射中移除
-                cache_map.erase(node.key);
-                
-                // 清理节点
-                node.in_cache = false;
-                value_deleter(node.value);
-                not_use.erase(node_iter);
-                size--;
+            while (usage > max_size) {
+                if (!not_use.empty()) {
+                    evict_node(not_use, not_use.begin());
+                } else if (!protected_list.empty()) {
+                    evict_node(protected_list, protected_list.begin());
+                } else {
+                    break;
+                }
+                if constexpr (kCacheStatsEnabled) {
+                    stats.evictions++;
+                }
             }
         }
     }
 
     size_t max_size;
     size_t size;
+    size_t usage;           // 缓存中条目的 charge 总和
+    size_t pinned_usage;    // in_use + to_del 条目的 charge 总和
+    size_t protected_usage; // protected 段（含被引用中的）条目的 charge 总和
+
+    // TTL 时间轮：kWheelSlots 个槽位，每槽 kWheelTickMs 毫秒，一圈约 100 秒
+    // 更长的 TTL 按取模落入槽位，清理时跳过未到期的节点
+    static constexpr size_t kWheelSlots = 1024;
+    static constexpr uint64_t kWheelTickMs = 100;
+    static constexpr size_t kPutSweepVisits = 8;    // 每次 put 顺带检查的节点数
+    std::vector<Node*> wheel;   // 首次插入带 TTL 的节点时才分配
+    uint64_t wheel_tick;        // 清理进度：正在（或下一个要）清理的 tick
+    bool sweeping;              // 是否正处于 wheel_tick 槽位的清理中
+    Node* sweep_cursor;         // 槽位内下一个要检查的节点
 
-    std::list<Node> not_use;   // ref=1: 未被外部使用（LRU 队列，头部=最久未使用）
+    std::list<Node> not_use;   // ref=1: 未被外部使用（LRU 队列，头部=最久未使用；分段策略下为 probation 段）
+    std::list<Node> protected_list; // ref=1: 分段策略下的 protected 段（头部=最久未使用）
     std::list<Node> in_use;    // ref>1: 外部正在使用（不参与 LRU 淘汰）
     std::list<Node> to_del;    // in_cache=false: 已移出缓存但外部仍引用（由 HandleGuard 清理）
     
     // 键到节点迭代器的映射
-    std::unordered_map<KEY, ListNodeIterator> cache_map;
+    std::unordered_map<KEY, ListNodeIterator, Hash> cache_map;
     ValueDeleter value_deleter;
+    Policy policy;
+    CacheStats stats;
+    mutable Mutex mutex;
 };
\ No newline at end of file
@@ -0,0 +1,312 @@
+// ShardedLRUCache.h
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "LRUCache.h"
+
+// ShardedLRUCache 实现：按 key 哈希分片的线程安全 LRU 缓存
+// 核心设计：
+// 1. 2^shard_bits 个分片，每个分片是一个带独立 std::mutex 的 LRUCache
+// 2. 每个分片独立维护 not_use / in_use / to_del，HandleGuard 只回到所属分片加锁释放
+// 3. set_max_size 的容量平均切分到各分片（向上取整），0 仍表示无限制
+// 4. Policy 透传给每个分片，各分片独立维护自己的分段与频率统计；Hash 既用于选择分片，也透传给分片的哈希表
+// 5. get_or_load 合并同一 key 的并发加载：每个分片记录正在加载的 key，同一 key 只有一个线程执行 loader，
+//    其余线程等待其结果并各自拿到指向同一节点的句柄
+template<typename KEY, typename VALUE, class ValueDeleter = DefaultValueDeleter<VALUE>,
+         class Hash = std::hash<KEY>, class Policy = LRUPolicy>
+class ShardedLRUCache {
+public:
+    using Shard = LRUCache<KEY, VALUE, ValueDeleter, std::mutex, Policy, Hash>;
+    using HandleGuard = typename Shard::HandleGuard;
+
+    // shard_bits = 4 即 16 个分片
+    explicit ShardedLRUCache(int shard_bits = 4)
+        : shard_bits(shard_bits), num_shards(size_t(1) << shard_bits), max_size(0),
+          shards(new PaddedShard[size_t(1) << shard_bits])
+    {
+        assert(shard_bits >= 0 && shard_bits < 16);
+    }
+
+    ShardedLRUCache(const ShardedLRUCache&) = delete;
+    ShardedLRUCache& operator=(const ShardedLRUCache&) = delete;
+    ShardedLRUCache(ShardedLRUCache&&) = delete;
+    ShardedLRUCache& operator=(ShardedLRUCache&&) = delete;
+
+    // 设置总容量（charge 总和上限），0表示无限制；每个分片分得 ceil(max_size / num_shards)
+    void set_max_size(size_t max_size)
+    {
+        this->max_size = max_size;
+        size_t per_shard = (max_size + num_shards - 1) / num_shards;
+        for (size_t i = 0; i < num_shards; i++) {
+            shards[i].cache.set_max_size(per_shard);
+        }
+    }
+
+    size_t get_max_size() const { return max_size; }
+
+    // 各分片大小之和（各分片分别加锁，结果为近似快照）
+    size_t get_size() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards; i++) {
+            total += shards[i].cache.get_size();
+        }
+        return total;
+    }
+
+    size_t get_usage() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards; i++) {
+            total += shards[i].cache.get_usage();
+        }
+        return total;
+    }
+
+    size_t get_pinned_usage() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards; i++) {
+            total += shards[i].cache.get_pinned_usage();
+        }
+        return total;
+    }
+
+    size_t get_num_shards() const { return num_shards; }
+
+    // 汇总各分片的统计（各分片分别加锁，结果为近似快照）
+    CacheStats get_stats() const
+    {
+        CacheStats total;
+        for (size_t i = 0; i < num_shards; i++) {
+            total += shards[i].cache.get_stats();
+        }
+        return total;
+    }
+
+    void reset_stats()
+    {
+        for (size_t i = 0; i < num_shards; i++) {
+            shards[i].cache.reset_stats();
+        }
+    }
+
+    void prune()
+    {
+        for (size_t i = 0; i < num_shards; i++) {
+            shards[i].cache.prune();
+        }
+    }
+
+    HandleGuard get(const KEY& key)
+    {
+        return shard_of(key).get(key);
+    }
+
+    template<typename V>
+    HandleGuard put(const KEY& key, V&& value, size_t charge = 1)
+    {
+        return shard_of(key).put(key, std::forward<V>(value), charge);
+    }
+
+    template<typename V, typename Rep, typename Period>
+    HandleGuard put(const KEY& key, V&& value, std::chrono::duration<Rep, Period> ttl, size_t charge = 1)
+    {
+        return shard_of(key).put(key, std::forward<V>(value), ttl, charge);
+    }
+
+    bool del(const KEY& key)
+    {
+        return shard_of(key).del(key);
+    }
+
+    // 未命中时调用 loader() 生成 value 并插入；同一 key 并发未命中时只有一个线程执行 loader
+    // loader 抛出的异常会传递给所有等待该 key 的调用方
+    template<class Loader>
+    HandleGuard get_or_load(const KEY& key, Loader&& loader, size_t charge = 1)
+    {
+        PaddedShard& shard = shards[shard_index(key)];
+        HandleGuard handle = shard.cache.get(key);
+        if (handle.valid()) {
+            return handle;
+        }
+
+        std::promise<std::shared_ptr<HandleGuard>> promise;
+        {
+            std::unique_lock<std::mutex> lock(shard.loading_mutex);
+            // 持锁复查：加载者先插入缓存、后移除 loading 记录，这里不会漏掉刚完成的结果
+            HandleGuard loaded = shard.cache.get(key);
+            if (loaded.valid()) {
+                return loaded;
+            }
+            auto it = shard.loading.find(key);
+            if (it != shard.loading.end()) {
+                std::shared_future<std::shared_ptr<HandleGuard>> result = it->second;
+                lock.unlock();
+                return result.get()->clone();
+            }
+            shard.loading.emplace(key, promise.get_future().share());
+        }
+
+        try {
+            HandleGuard result = shard.cache.put(key, loader(), charge);
+            promise.set_value(std::make_shared<HandleGuard>(result.clone()));
+            finish_loading(shard, key);
+            return result;
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            finish_loading(shard, key);
+            throw;
+        }
+    }
+
+    // get_or_load 的异步版本：命中时直接返回就绪的 future，未命中时把加载任务提交到 pool
+    // pool 需提供 ThreadPool::Enqueue 形式的接口
+    template<class Loader, class Pool>
+    std::future<HandleGuard> get_or_load_async(const KEY& key, Loader loader, Pool& pool, size_t charge = 1)
+    {
+        HandleGuard handle = get(key);
+        if (handle.valid()) {
+            std::promise<HandleGuard> ready;
+            ready.set_value(std::move(handle));
+            return ready.get_future();
+        }
+        return pool.Enqueue([this, key, loader = std::move(loader), charge]() mutable {
+            return get_or_load(key, loader, charge);
+        });
+    }
+
+    // 增量清理过期节点：每个分片最多检查 max_visits 个节点，返回移除的总数
+    size_t expire(size_t max_visits = 64)
+    {
+        size_t removed = 0;
+        for (size_t i = 0; i < num_shards; i++) {
+            removed += shards[i].cache.expire(max_visits);
+        }
+        return removed;
+    }
+
+    // 批量获取：先算出全部分片号并按分片分组，每个分片只加一次锁
+    // 结果与 keys 一一对应（未命中为无效句柄）
+    std::vector<HandleGuard> multi_get(const KEY* keys, size_t count)
+    {
+        std::vector<uint32_t> shard_ids, order;
+        std::vector<size_t> offsets;
+        group_by_shard(keys, count, shard_ids, order, offsets);
+
+        std::vector<std::vector<HandleGuard>> per_shard(num_shards);
+        for (size_t s = 0; s < num_shards; s++) {
+            const uint32_t* group = order.data() + offsets[s];
+            size_t n = offsets[s + 1] - offsets[s];
+            if (n > 0) {
+                per_shard[s] = shards[s].cache.multi_get_by(
+                    [keys, group](size_t i) -> const KEY& { return keys[group[i]]; }, n);
+            }
+        }
+        return gather(shard_ids, per_shard);
+    }
+
+    std::vector<HandleGuard> multi_get(const std::vector<KEY>& keys)
+    {
+        return multi_get(keys.data(), keys.size());
+    }
+
+    // 批量插入：按分片分组后每个分片只加一次锁，charges 为空时每个条目 charge 为 1
+    std::vector<HandleGuard> multi_put(const KEY* keys, const VALUE* values, size_t count,
+                                       const size_t* charges = nullptr)
+    {
+        std::vector<uint32_t> shard_ids, order;
+        std::vector<size_t> offsets;
+        group_by_shard(keys, count, shard_ids, order, offsets);
+
+        std::vector<std::vector<HandleGuard>> per_shard(num_shards);
+        for (size_t s = 0; s < num_shards; s++) {
+            const uint32_t* group = order.data() + offsets[s];
+            size_t n = offsets[s + 1] - offsets[s];
+            if (n > 0) {
+                per_shard[s] = shards[s].cache.multi_put_by(
+                    [keys, group](size_t i) -> const KEY& { return keys[group[i]]; },
+                    [values, group](size_t i) -> const VALUE& { return values[group[i]]; },
+                    [charges, group](size_t i) { return charges ? charges[group[i]] : size_t(1); },
+                    n);
+            }
+        }
+        return gather(shard_ids, per_shard);
+    }
+
+private:
+    // 对齐到缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(64) PaddedShard {
+        Shard cache;
+        std::mutex loading_mutex;   // 保护 loading
+        std::unordered_map<KEY, std::shared_future<std::shared_ptr<HandleGuard>>, Hash> loading;
+    };
+
+    void finish_loading(PaddedShard& shard, const KEY& key)
+    {
+        std::lock_guard<std::mutex> lock(shard.loading_mutex);
+        shard.loading.erase(key);
+    }
+
+    // 取混合后哈希的高位作为分片号，与 unordered_map 使用的低位桶号解耦
+    size_t shard_index(const KEY& key) const
+    {
+        if (shard_bits == 0) {
+            return 0;
+        }
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> (64 - shard_bits));
+    }
+
+    Shard& shard_of(const KEY& key)
+    {
+        return shards[shard_index(key)].cache;
+    }
+
+    // 计数排序：order 中同一分片的下标连续且保持原有相对顺序，
+    // 分片 s 的下标位于 order[offsets[s], offsets[s + 1])
+    void group_by_shard(const KEY* keys, size_t count, std::vector<uint32_t>& shard_ids,
+                        std::vector<uint32_t>& order, std::vector<size_t>& offsets) const
+    {
+        shard_ids.resize(count);
+        offsets.assign(num_shards + 1, 0);
+        for (size_t i = 0; i < count; i++) {
+            shard_ids[i] = static_cast<uint32_t>(shard_index(keys[i]));
+            offsets[shard_ids[i] + 1]++;
+        }
+        for (size_t s = 0; s < num_shards; s++) {
+            offsets[s + 1] += offsets[s];
+        }
+        order.resize(count);
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < count; i++) {
+            order[cursor[shard_ids[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // 按原始顺序把各分片的结果拼回一个数组
+    std::vector<HandleGuard> gather(const std::vector<uint32_t>& shard_ids,
+                                    std::vector<std::vector<HandleGuard>>& per_shard) const
+    {
+        std::vector<HandleGuard> handles;
+        handles.reserve(shard_ids.size());
+        std::vector<size_t> cursor(num_shards, 0);
+        for (uint32_t s : shard_ids) {
+            handles.push_back(std::move(per_shard[s][cursor[s]++]));
+        }
+        return handles;
+    }
+
+    int shard_bits;
+    size_t num_shards;
+    size_t max_size;
+    std::unique_ptr<PaddedShard[]> shards;
+    Hash hasher;
+};
@@ -0,0 +1,480 @@
+// SlabLRUCache.h
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "LRUCache.h"
+
+// SlabLRUCache 实现：预分配节点池 + 侵入式链表 + 开放寻址哈希表的 LRU 缓存
+// 语义与 LRUCache 一致（not_use / in_use / to_del 三个列表 + HandleGuard 引用计数），区别在于：
+// 1. 所有节点在构造时按 max_size 一次性分配，链表通过节点下标 prev/next 串联，稳态 put/get 不再分配内存
+//    （KEY / VALUE 自身拷贝时的分配除外）
+// 2. 哈希表使用线性探测，桶中只存节点下标和哈希高 32 位，删除时后移回填，不留墓碑
+// 3. 容量固定：节点全部被外部引用（in_use / to_del）时，put 无法腾出节点，返回无效句柄
+//    （更新已有的 key 时旧节点仍会移出缓存）
+// 4. 批量接口先在锁外算出全部哈希并预取桶，再在一次加锁内完成整批查找
+template<typename KEY, typename VALUE, class ValueDeleter = DefaultValueDeleter<VALUE>,
+         class Mutex = NullMutex, class Hash = std::hash<KEY>>
+class SlabLRUCache {
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    // 缓存节点结构
+    struct Node {
+        std::optional<KEY> key;
+        std::optional<VALUE> value;
+        uint64_t hash = 0;
+        uint32_t prev = kNil;       // 侵入式链表前驱（节点下标）
+        uint32_t next = kNil;       // 侵入式链表后继；空闲时串联 free 链
+        int ref = 0;                // 引用计数（外部持有 + 缓存自身）
+        bool in_cache = false;      // 是否在缓存中（用于状态判断）
+    };
+
+    // 侵入式双向链表（头部 = 最久未使用）
+    struct List {
+        uint32_t head = kNil;
+        uint32_t tail = kNil;
+        bool empty() const { return head == kNil; }
+    };
+
+    // 哈希桶：节点下标 + 哈希高 32 位（先比 tag 再比 key，减少访问节点）
+    struct Bucket {
+        uint32_t index = kNil;
+        uint32_t tag = 0;
+    };
+
+public:
+    // RAII 安全句柄：自动管理引用计数
+    class HandleGuard {
+    public:
+        ~HandleGuard() {
+            reset();
+        }
+
+        // 禁用拷贝
+        HandleGuard(const HandleGuard&) = delete;
+        HandleGuard& operator=(const HandleGuard&) = delete;
+        // 禁用移动赋值
+        HandleGuard& operator=(HandleGuard&&) = delete;
+
+        // 允许移动构造
+        HandleGuard(HandleGuard&& other) noexcept
+            : cache(other.cache), node(other.node)
+        {
+            other.cache = nullptr;
+            other.node = nullptr;
+        }
+
+        // 显式释放资源
+        void reset() {
+            if (valid()) {
+                cache->release(node);
+                cache = nullptr;
+                node = nullptr;
+            }
+        }
+
+        VALUE& value() const {
+            assert(valid());
+            return *node->value;
+        }
+
+        const KEY& key() const {
+            assert(valid());
+            return *node->key;
+        }
+
+        bool valid() const {
+            return cache && node;
+        }
+
+        explicit operator bool() const { return valid(); }
+
+    private:
+        HandleGuard() : cache(nullptr), node(nullptr) {}
+        // 只允许 SlabLRUCache 在持锁状态下构造
+        explicit HandleGuard(SlabLRUCache* cache, Node* node)
+            : cache(cache), node(node)
+        {
+            if (cache && node) {
+                cache->ref_node(node);
+            }
+        }
+        friend class SlabLRUCache;
+        SlabLRUCache* cache;
+        Node* node;
+    };
+
+public:
+    // 构造函数：按 max_size 预分配节点池和哈希表（桶数 >= 2 * max_size，取 2 的幂）
+    explicit SlabLRUCache(size_t max_size)
+        : capacity(max_size), max_size(max_size), size(0), bucket_mask(0)
+    {
+        assert(max_size > 0 && max_size < kNil);
+        size_t num_buckets = 1;
+        while (num_buckets < max_size * 2) {
+            num_buckets <<= 1;
+        }
+        bucket_mask = num_buckets - 1;
+        nodes.reset(new Node[capacity]);
+        buckets.reset(new Bucket[num_buckets]);
+
+        // 所有节点串入空闲链
+        for (size_t i = 0; i < capacity; i++) {
+            nodes[i].next = (i + 1 < capacity) ? static_cast<uint32_t>(i + 1) : kNil;
+        }
+        free_head = 0;
+    }
+
+    // 析构函数：确保所有资源被安全释放
+    ~SlabLRUCache()
+    {
+        // 如果外部仍在使用 SlabLRUCache，则报错
+        assert(in_use.empty());
+        assert(to_del.empty());
+        // 清理所有缓存
+        prune();
+    }
+
+    // Disable copy and move
+    SlabLRUCache(const SlabLRUCache&) = delete;
+    SlabLRUCache& operator=(const SlabLRUCache&) = delete;
+    SlabLRUCache(SlabLRUCache&&) = delete;
+    SlabLRUCache& operator=(SlabLRUCache&&) = delete;
+
+    // 调整最大容量，不能超过构造时预分配的节点数
+    void set_max_size(size_t max_size)
+    {
+        assert(max_size > 0 && max_size <= capacity);
+        std::lock_guard<Mutex> lock(mutex);
+        this->max_size = max_size;
+        evict_if_needed(0);
+    }
+
+    size_t get_max_size() const { return max_size; }
+    size_t get_capacity() const { return capacity; }
+    size_t get_size() const
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        return size;
+    }
+
+    // 清除所有未被使用的缓存
+    void prune()
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        while (!not_use.empty()) {
+            evict(not_use.head);
+        }
+    }
+
+    // 获取缓存项
+    HandleGuard get(const KEY& key)
+    {
+        uint64_t hash = hasher(key);
+        std::lock_guard<Mutex> lock(mutex);
+        return get_locked(key, hash);
+    }
+
+    // 插入缓存项；所有节点都被外部引用时返回无效句柄
+    template<typename V>
+    HandleGuard put(const KEY& key, V&& value)
+    {
+        static_assert(std::is_constructible_v<VALUE, V&&>, "value 必须用来构造 VALUE");
+        uint64_t hash = hasher(key);
+        std::lock_guard<Mutex> lock(mutex);
+        return put_locked(key, hash, std::forward<V>(value));
+    }
+
+    // 批量获取：结果与 keys 一一对应（未命中为无效句柄）
+    std::vector<HandleGuard> multi_get(const KEY* keys, size_t count)
+    {
+        std::vector<uint64_t> hashes = hash_and_prefetch(keys, count);
+        std::vector<HandleGuard> handles;
+        handles.reserve(count);
+        std::lock_guard<Mutex> lock(mutex);
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(get_locked(keys[i], hashes[i]));
+        }
+        return handles;
+    }
+
+    std::vector<HandleGuard> multi_get(const std::vector<KEY>& keys)
+    {
+        return multi_get(keys.data(), keys.size());
+    }
+
+    // 批量插入：结果与 keys 一一对应
+    std::vector<HandleGuard> multi_put(const KEY* keys, const VALUE* values, size_t count)
+    {
+        std::vector<uint64_t> hashes = hash_and_prefetch(keys, count);
+        std::vector<HandleGuard> handles;
+        handles.reserve(count);
+        std::lock_guard<Mutex> lock(mutex);
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(put_locked(keys[i], hashes[i], values[i]));
+        }
+        return handles;
+    }
+
+    // 删除缓存项（从缓存中移除，不释放内存）
+    bool del(const KEY& key)
+    {
+        uint64_t hash = hasher(key);
+        std::lock_guard<Mutex> lock(mutex);
+        size_t pos = find(key, hash);
+        if (pos == kNotFound) {
+            return false;
+        }
+        erase_locked(pos);
+        return true;
+    }
+
+private:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    // 获取缓存项（调用方需持锁）
+    HandleGuard get_locked(const KEY& key, uint64_t hash)
+    {
+        size_t pos = find(key, hash);
+        if (pos != kNotFound) {
+            return HandleGuard(this, &nodes[buckets[pos].index]);
+        }
+        return HandleGuard();
+    }
+
+    // 将桶 pos 上的节点移出缓存（调用方需持锁）
+    void erase_locked(size_t pos)
+    {
+        uint32_t index = buckets[pos].index;
+        Node& node = nodes[index];
+        erase_bucket(pos);
+
+        if (node.ref == 1) {
+            // 仅缓存持有：直接从 not_use 移除并清理
+            unlink(not_use, index);
+            free_node(index);
+        } else {
+            // 外部持有：移入 to_del（由 HandleGuard 清理）
+            unlink(in_use, index);
+            link_back(to_del, index);
+            node.in_cache = false;
+            node.ref--;   // 释放缓存引用
+        }
+        size--;
+    }
+
+    // 插入缓存项（调用方需持锁）
+    template<typename V>
+    HandleGuard put_locked(const KEY& key, uint64_t hash, V&& value)
+    {
+        size_t pos = find(key, hash);
+        if (pos != kNotFound) {
+            // 键已存在：新值放入新节点，旧节点移出缓存（无人引用时立即清理，否则进入 to_del）
+            // 不能原地赋值：其他线程可能正持有旧节点的句柄，在锁外读取 value
+            erase_locked(pos);
+        }
+
+        // 先淘汰再分配，保证 size 不超过 max_size
+        evict_if_needed(1);
+        if (size >= max_size || free_head == kNil) {
+            return HandleGuard();
+        }
+
+        uint32_t index = free_head;
+        Node& node = nodes[index];
+        free_head = node.next;
+
+        node.key.emplace(key);
+        node.value.emplace(std::forward<V>(value));
+        node.hash = hash;
+        node.ref = 1;   // 1 for cache
+        node.in_cache = true;
+        link_back(not_use, index);
+        insert_bucket(index);
+        size++;
+
+        return HandleGuard(this, &node);
+    }
+
+
+    // 锁外计算整批哈希并预取各 key 的起始桶
+    std::vector<uint64_t> hash_and_prefetch(const KEY* keys, size_t count) const
+    {
+        std::vector<uint64_t> hashes(count);
+        for (size_t i = 0; i < count; i++) {
+            hashes[i] = hasher(keys[i]);
+            __builtin_prefetch(&buckets[home_of(hashes[i])]);
+        }
+        return hashes;
+    }
+
+    uint32_t index_of(const Node* node) const {
+        return static_cast<uint32_t>(node - nodes.get());
+    }
+
+    // HandleGuard 释放入口：加锁后减少引用
+    void release(Node* node) {
+        std::lock_guard<Mutex> lock(mutex);
+        unref_node(node);
+    }
+
+    // 增加节点引用（调用方需持锁）
+    void ref_node(Node* node) {
+        if (node->in_cache && node->ref == 1) {
+            // 从 not_use 移入 in_use（表示节点被外部使用）
+            uint32_t index = index_of(node);
+            unlink(not_use, index);
+            link_back(in_use, index);
+        }
+        node->ref++;
+    }
+
+    // 减少节点引用（调用方需持锁）
+    void unref_node(Node* node) {
+        assert(node->ref > 0);
+        node->ref--;
+        uint32_t index = index_of(node);
+
+        if (node->ref == 0) {
+            // 无引用：从 to_del 中移除并清理
+            assert(!node->in_cache);
+            unlink(to_del, index);
+            free_node(index);
+        } else if (node->in_cache && node->ref == 1) {
+            // 从 in_use 移入 not_use（表示节点可被 LRU 淘汰）
+            unlink(in_use, index);
+            link_back(not_use, index);
+        }
+    }
+
+    // 淘汰检查：为即将插入的 incoming 个节点腾出空间
+    void evict_if_needed(size_t incoming) {
+        while (size + incoming > max_size && !not_use.empty()) {
+            evict(not_use.head);
+        }
+    }
+
+    // 淘汰 not_use 中的节点（调用方需持锁）
+    void evict(uint32_t index) {
+        Node& node = nodes[index];
+        assert(node.in_cache && node.ref == 1);
+        erase_bucket(find(*node.key, node.hash));
+        unlink(not_use, index);
+        free_node(index);
+        size--;
+    }
+
+    // 清理节点并归还空闲链
+    void free_node(uint32_t index) {
+        Node& node = nodes[index];
+        node.in_cache = false;
+        node.ref = 0;
+        value_deleter(*node.value);
+        node.value.reset();
+        node.key.reset();
+        node.prev = kNil;
+        node.next = free_head;
+        free_head = index;
+    }
+
+    void link_back(List& list, uint32_t index) {
+        Node& node = nodes[index];
+        node.prev = list.tail;
+        node.next = kNil;
+        if (list.tail != kNil) {
+            nodes[list.tail].next = index;
+        } else {
+            list.head = index;
+        }
+        list.tail = index;
+    }
+
+    void unlink(List& list, uint32_t index) {
+        Node& node = nodes[index];
+        if (node.prev != kNil) {
+            nodes[node.prev].next = node.next;
+        } else {
+            list.head = node.next;
+        }
+        if (node.next != kNil) {
+            nodes[node.next].prev = node.prev;
+        } else {
+            list.tail = node.prev;
+        }
+        node.prev = node.next = kNil;
+    }
+
+    static uint32_t tag_of(uint64_t hash) {
+        return static_cast<uint32_t>(hash >> 32);
+    }
+
+    // 将 std::hash 的结果打散（整数的 std::hash 是恒等映射）
+    size_t home_of(uint64_t hash) const {
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> 32) & bucket_mask;
+    }
+
+    // 线性探测查找，返回桶下标
+    size_t find(const KEY& key, uint64_t hash) const {
+        uint32_t tag = tag_of(hash);
+        for (size_t pos = home_of(hash); ; pos = (pos + 1) & bucket_mask) {
+            const Bucket& bucket = buckets[pos];
+            if (bucket.index == kNil) {
+                return kNotFound;
+            }
+            if (bucket.tag == tag && *nodes[bucket.index].key == key) {
+                return pos;
+            }
+        }
+    }
+
+    // 桶数 >= 2 * 节点数，必有空桶
+    void insert_bucket(uint32_t index) {
+        uint64_t hash = nodes[index].hash;
+        size_t pos = home_of(hash);
+        while (buckets[pos].index != kNil) {
+            pos = (pos + 1) & bucket_mask;
+        }
+        buckets[pos].index = index;
+        buckets[pos].tag = tag_of(hash);
+    }
+
+    // 后移回填删除：把探测链上后续元素前移，保持查找不被空洞截断
+    void erase_bucket(size_t pos) {
+        assert(pos != kNotFound);
+        size_t hole = pos;
+        for (size_t next = (hole + 1) & bucket_mask; buckets[next].index != kNil;
+             next = (next + 1) & bucket_mask) {
+            size_t home = home_of(nodes[buckets[next].index].hash);
+            // home 不在 (hole, next] 区间内时，该元素可以前移到 hole
+            bool movable = (hole <= next) ? (home <= hole || home > next)
+                                          : (home <= hole && home > next);
+            if (movable) {
+                buckets[hole] = buckets[next];
+                hole = next;
+            }
+        }
+        buckets[hole] = Bucket();
+    }
+
+    size_t capacity;
+    size_t max_size;
+    size_t size;
+    size_t bucket_mask;
+    uint32_t free_head;
+
+    List not_use;   // ref=1: 未被外部使用（LRU 队列，头部=最久未使用）
+    List in_use;    // ref>1: 外部正在使用（不参与 LRU 淘汰）
+    List to_del;    // in_cache=false: 已移出缓存但外部仍引用（由 HandleGuard 清理）
+
+    std::unique_ptr<Node[]> nodes;      // 节点池
+    std::unique_ptr<Bucket[]> buckets;  // 开放寻址哈希表
+    Hash hasher;
+    ValueDeleter value_deleter;
+    mutable Mutex mutex;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// 按大小分级的缓冲块池，每个 EventLoop 一个，只在 loop 线程中使用，不加锁
+// 1. 大小级别为 4 KiB ~ 1 MiB 的 2 的幂，申请的大小向上取整到所属级别；更大的块直接 malloc / free
+// 2. 块用 malloc 分配，不做零初始化
+// 3. 归还的块按级别缓存，每个级别缓存的总字节数有上限，超出的直接释放，连接数回落后内存能还给系统
+class BufferPool
+{
+public:
+    static constexpr std::size_t kMinChunkShift = 12; // 4 KiB
+    static constexpr std::size_t kMaxChunkShift = 20; // 1 MiB
+    static constexpr std::size_t kNumClasses = kMaxChunkShift - kMinChunkShift + 1;
+
+    explicit BufferPool(std::size_t max_cached_bytes_per_class = 4 << 20)
+        : max_cached_bytes_per_class_(max_cached_bytes_per_class)
+    {
+    }
+
+    ~BufferPool()
+    {
+        for (auto &chunks : free_)
+        {
+            for (uint8_t *chunk : chunks)
+            {
+                std::free(chunk);
+            }
+        }
+    }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // size 向上取整到所属级别
+    static std::size_t RoundUp(std::size_t size)
+    {
+        if (size > (std::size_t(1) << kMaxChunkShift))
+        {
+            return size;
+        }
+        return std::size_t(1) << (kMinChunkShift + ClassOf(size));
+    }
+
+    // 返回至少 *size 字节的未初始化块，*size 更新为块的实际大小
+    uint8_t *Acquire(std::size_t *size)
+    {
+        *size = RoundUp(*size);
+        if (*size <= (std::size_t(1) << kMaxChunkShift))
+        {
+            std::vector<uint8_t *> &chunks = free_[ClassOf(*size)];
+            if (!chunks.empty())
+            {
+                uint8_t *chunk = chunks.back();
+                chunks.pop_back();
+                cached_bytes_ -= *size;
+                return chunk;
+            }
+        }
+        uint8_t *chunk = static_cast<uint8_t *>(std::malloc(*size));
+        if (chunk == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return chunk;
+    }
+
+    // size 必须是 Acquire 返回的大小
+    void Release(uint8_t *chunk, std::size_t size)
+    {
+        if (size <= (std::size_t(1) << kMaxChunkShift))
+        {
+            std::vector<uint8_t *> &chunks = free_[ClassOf(size)];
+            if ((chunks.size() + 1) * size <= max_cached_bytes_per_class_)
+            {
+                chunks.push_back(chunk);
+                cached_bytes_ += size;
+                return;
+            }
+        }
+        std::free(chunk);
+    }
+
+    // 池中缓存的总字节数
+    std::size_t GetCachedBytes() const
+    {
+        return cached_bytes_;
+    }
+
+private:
+    static std::size_t ClassOf(std::size_t size)
+    {
+        std::size_t cls = 0;
+        while ((std::size_t(1) << (kMinChunkShift + cls)) < size)
+        {
+            cls++;
+        }
+        return cls;
+    }
+
+    std::vector<uint8_t *> free_[kNumClasses];
+    std::size_t max_cached_bytes_per_class_;
+    std::size_t cached_bytes_ = 0;
+};
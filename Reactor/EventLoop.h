@@ -1,33 +1,197 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
+#include "BufferPool.h"
+#include "MessageBuffer.h"
+#include "MpscQueue.h"
 #include "Timer.h"
 
 #define MAX_EVENTS 1024
 
+// one loop per thread：EventLoop 需在运行它的线程中创建，并拥有自己的定时器
+// 1. 构造时把自己的定时器设为本线程的 TimerInstance()，事件回调中的 TimerInstance() 即本 loop 的定时器
+// 2. RunAfter / RunAt / RunInLoop / QueueInLoop / Quit 可以在任意线程调用：非所属线程的请求放入待执行队列，通过 eventfd 唤醒 loop 执行
+//    待执行队列是无锁 MPSC 队列，loop 每轮处理完事件与定时器后整批取出执行；只在队列由空变为非空时写 eventfd
+// 3. use_timerfd 为 true 时定时器由 timerfd 驱动：timerfd 注册在 epoll 中，epoll_wait 不再带超时，
+//    定时精度为微秒；否则沿用以 WaitTime() 作为 epoll_wait 超时（毫秒精度）的方式
+// 4. 等待数据源可读（如 TcpConn::SendFile 的管道）用 AddSourceWaiter：同一个 fd 可以有多个等待者（如多个连接发送同一个管道），
+//    在 epoll 中只注册一次，可读时一次性通知当前全部等待者；没有等待者时从 epoll 中删除
 class EventLoop
 {
 public:
-    EventLoop() : epfd_(::epoll_create1(0))
+    // AddEvent / ModEvent 的 ptr 指向 EventHandler，事件就绪时以 epoll 返回的事件掩码调用
+    using EventHandler = std::function<void(uint32_t)>;
+
+    explicit EventLoop(bool use_timerfd = false)
+        : epfd_(::epoll_create1(0)),
+          wakeup_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+          use_timerfd_(use_timerfd),
+          quit_(false),
+          thread_id_(std::this_thread::get_id())
     {
         if (epfd_ == -1)
         {
             std::cerr << "epoll_create error: " << errno << std::endl;
             exit(EXIT_FAILURE);
         }
+        if (wakeup_fd_ == -1)
+        {
+            std::cerr << "eventfd error: " << errno << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        Timer::SetInstance(&timer_);
+
+        wakeup_handler_ = [this](uint32_t) {
+            uint64_t n;
+            ::read(wakeup_fd_, &n, sizeof(n));
+        };
+        AddEvent(wakeup_fd_, EPOLLIN, &wakeup_handler_);
+
+        if (use_timerfd_)
+        {
+            int timer_fd = timer_.TimerFd();
+            if (timer_fd == -1)
+            {
+                use_timerfd_ = false;
+            }
+            else
+            {
+                timer_handler_ = [this](uint32_t) { timer_.ReadTimerFd(); };
+                AddEvent(timer_fd, EPOLLIN, &timer_handler_);
+            }
+        }
     }
 
     ~EventLoop()
     {
+        // 未执行的任务与定时器回调可能持有连接的最后一个引用，连接析构时要从 epoll 中删除 fd、把读缓冲区还给缓冲块池：
+        // 先丢弃它们（不执行），再关闭 epfd_
+        while (pending_.ConsumeAll([](InlineCallback<void()> &) {}) > 0)
+        {
+        }
+        timer_.Clear();
+        while (quitting_ > 0)
+        {
+            std::this_thread::yield();
+        }
+        if (IsInLoopThread() && Timer::GetInstance() == &timer_)
+        {
+            Timer::SetInstance(nullptr);
+        }
+        close(wakeup_fd_);
         close(epfd_);
     }
 
-    void AddEvent(int fd, uint32_t events, void *ptr)
+    bool IsInLoopThread() const
+    {
+        return std::this_thread::get_id() == thread_id_;
+    }
+
+    bool UsesTimerFd() const
+    {
+        return use_timerfd_;
+    }
+
+    // 本 loop 上连接的读缓冲区共用的缓冲块池，只能在所属线程中使用
+    BufferPool &GetBufferPool()
+    {
+        return buffer_pool_;
+    }
+
+    // 本 loop 上连接读取时共用的溢出区（同一时刻只有一个连接在读），存储同样来自缓冲块池
+    MessageBuffer &GetReadScratch()
+    {
+        return read_scratch_;
+    }
+
+    // 本 loop 的定时器，只能在所属线程中使用；其他线程请用 RunAfter / RunAt
+    Timer &GetTimer()
+    {
+        return timer_;
+    }
+
+    // 线程安全：delay 毫秒后在所属线程执行 cb
+    template <class F>
+    void RunAfter(uint64_t delay, F &&cb)
+    {
+        RunAt(Timer::GetCurrentTimeUs() + delay * 1000, std::forward<F>(cb));
+    }
+
+    template <class Rep, class Period, class F>
+    void RunAfter(std::chrono::duration<Rep, Period> delay, F &&cb)
+    {
+        uint64_t delay_us = std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+        RunAt(Timer::GetCurrentTimeUs() + delay_us, std::forward<F>(cb));
+    }
+
+    // 线程安全：在绝对时间 time_us（Timer::GetCurrentTimeUs 的时间基准）于所属线程执行 cb
+    template <class F>
+    void RunAt(uint64_t time_us, F &&cb)
+    {
+        if (IsInLoopThread())
+        {
+            timer_.AddTimeoutAt(time_us, std::forward<F>(cb));
+            return;
+        }
+        QueueInLoop([this, time_us, cb = std::decay_t<F>(std::forward<F>(cb))]() mutable {
+            timer_.AddTimeoutAt(time_us, std::move(cb));
+        });
+    }
+
+    // 线程安全：在所属线程中执行 cb，当前就在所属线程时立即执行
+    template <class F>
+    void RunInLoop(F &&cb)
+    {
+        if (IsInLoopThread())
+        {
+            cb();
+        }
+        else
+        {
+            QueueInLoop(std::forward<F>(cb));
+        }
+    }
+
+    // 线程安全：把 cb 放入待执行队列，在本轮事件与定时器处理完后执行
+    template <class F>
+    void QueueInLoop(F &&cb)
+    {
+        // 队列原本非空时已有人唤醒过 loop；所属线程在处理事件时投递的任务本轮末尾就会执行，
+        // 只有在执行待执行任务期间投递的才需要唤醒下一轮
+        bool was_empty = pending_.Push(std::forward<F>(cb));
+        if (was_empty && (!IsInLoopThread() || calling_pending_))
+        {
+            Wakeup();
+        }
+    }
+
+    // 线程安全：当前这一轮处理完后退出 Run
+    void Quit()
+    {
+        if (IsInLoopThread())
+        {
+            quit_ = true;
+            return;
+        }
+        // loop 看到 quit_ 后可能立即退出并析构，析构要等这里写完 eventfd 才能关闭它
+        quitting_++;
+        quit_ = true;
+        Wakeup();
+        quitting_--;
+    }
+
+    bool AddEvent(int fd, uint32_t events, void *ptr)
     {
         epoll_event ev;
         ev.events = events;
@@ -35,7 +199,9 @@ public:
         if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1)
         {
             std::cerr << "epoll_ctl add error: " << errno << std::endl;
+            return false;
         }
+        return true;
     }
 
     void ModEvent(int fd, uint32_t events, void *ptr)
@@ -57,12 +223,75 @@ public:
         }
     }
 
+    // fd 可读时以事件掩码调用 waiter，只通知一次：waiter 需要继续等待时再次添加
+    // fd 已因其他用途注册在本 loop 上时返回 false
+    bool AddSourceWaiter(int fd, EventHandler *waiter)
+    {
+        SourceWaiters &source = source_waiters_[fd];
+        if (source.waiters.empty())
+        {
+            if (!source.handler)
+            {
+                source.handler = [this, fd](uint32_t events) { NotifySourceWaiters(fd, events); };
+            }
+            if (!AddEvent(fd, EPOLLIN, &source.handler))
+            {
+                return false;
+            }
+        }
+        source.waiters.push_back(waiter);
+        return true;
+    }
+
+    void RemoveSourceWaiter(int fd, EventHandler *waiter)
+    {
+        if (notifying_ && notifying_fd_ == fd)
+        {
+            std::replace(notifying_->begin(), notifying_->end(), waiter, static_cast<EventHandler *>(nullptr));
+        }
+        auto it = source_waiters_.find(fd);
+        if (it == source_waiters_.end())
+        {
+            return;
+        }
+        std::vector<EventHandler *> &waiters = it->second.waiters;
+        auto pos = std::find(waiters.begin(), waiters.end(), waiter);
+        if (pos == waiters.end())
+        {
+            return;
+        }
+        waiters.erase(pos);
+        if (waiters.empty())
+        {
+            DelEvent(fd);
+        }
+    }
+
     void Run()
     {
+        if (!IsInLoopThread())
+        {
+            std::cerr << "EventLoop::Run must be called in the thread that created the loop" << std::endl;
+            return;
+        }
         epoll_event events[MAX_EVENTS];
-        while (true)
+        while (!quit_)
         {
-            int nfds = ::epoll_wait(epfd_, events, MAX_EVENTS, TimerInstance()->WaitTime());
+            int timeout = -1;
+            if (use_timerfd_)
+            {
+                // 仅在最近到期时间变化时才重新设置 timerfd
+                timer_.ArmTimerFd();
+            }
+            else
+            {
+                timeout = timer_.WaitTime();
+            }
+            if (!pending_.Empty())
+            {
+                timeout = 0;
+            }
+            int nfds = ::epoll_wait(epfd_, events, MAX_EVENTS, timeout);
             if (nfds == -1)
             {
                 if (errno == EINTR)
@@ -73,14 +302,74 @@ public:
 
             for (int i = 0; i < nfds; ++i)
             {
-                auto handler = static_cast<std::function<void()> *>(events[i].data.ptr);
-                (*handler)();
+                auto handler = static_cast<EventHandler *>(events[i].data.ptr);
+                (*handler)(events[i].events);
             }
-            // 处理定时器
-            TimerInstance()->HandleTimeout();
+            // 处理定时器：每轮只读取一次时钟
+            timer_.HandleTimeout(Timer::GetCurrentTimeUs());
+            // 执行其他线程投递的任务
+            DoPendingFunctors();
         }
     }
 
 private:
+    void Wakeup()
+    {
+        uint64_t one = 1;
+        ::write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    // 先整批取出再逐个通知：等待者在回调中可能让其他等待者移除（如关闭了它们的连接），被移除的置空跳过
+    void NotifySourceWaiters(int fd, uint32_t events)
+    {
+        std::vector<EventHandler *> waiters;
+        waiters.swap(source_waiters_[fd].waiters);
+        DelEvent(fd);
+        notifying_fd_ = fd;
+        notifying_ = &waiters;
+        for (EventHandler *waiter : waiters)
+        {
+            if (waiter)
+            {
+                (*waiter)(events);
+            }
+        }
+        notifying_ = nullptr;
+    }
+
+    // 整批取出再执行，回调中再投递的任务留到下一轮
+    void DoPendingFunctors()
+    {
+        // functor 抛出异常时同样要复位，否则之后在 loop 线程中 QueueInLoop 都会多一次 Wakeup
+        struct CallingGuard
+        {
+            bool &calling;
+            explicit CallingGuard(bool &flag) : calling(flag) { calling = true; }
+            ~CallingGuard() { calling = false; }
+        } guard(calling_pending_);
+        pending_.ConsumeAll([](InlineCallback<void()> &functor) { functor(); });
+    }
+
     int epfd_;
+    int wakeup_fd_;
+    bool use_timerfd_;
+    std::atomic<bool> quit_;
+    std::atomic<int> quitting_{0};     // 其他线程中正在执行的 Quit 个数
+    const std::thread::id thread_id_;
+    Timer timer_;
+    BufferPool buffer_pool_;
+    MessageBuffer read_scratch_{&buffer_pool_};
+    EventHandler timer_handler_;
+    EventHandler wakeup_handler_;
+    bool calling_pending_ = false;
+    MpscQueue<InlineCallback<void()>> pending_;
+    // 数据源 fd 的等待者；handler 是注册在 epoll 中的分发函数，条目不删除以保证其地址不变
+    struct SourceWaiters
+    {
+        EventHandler handler;
+        std::vector<EventHandler *> waiters;
+    };
+    std::unordered_map<int, SourceWaiters> source_waiters_;
+    std::vector<EventHandler *> *notifying_ = nullptr;   // 正在通知的等待者，见 NotifySourceWaiters
+    int notifying_fd_ = -1;
 };
\ No newline at end of file
@@ -2,22 +2,55 @@
 
 #include <bits/types/struct_iovec.h>
 #include <stdint.h>
-#include <vector>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <sys/uio.h>
 #include <errno.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "BufferPool.h"
 
+// 存储为一块未初始化的内存，按需分配：
+// 1. 默认构造不分配，第一次写入 / Recv 时才分配；MessageBuffer(size) 立即分配 size 字节
+// 2. 传入 BufferPool 时存储从池中借用（大小取整到池的级别），Shrink 时归还
+// 3. Shrink：数据读空时释放存储，否则数据不到容量的 1/4 时换到更小的块；
+//    连接在每次读回调后调用，闲置连接不占用缓冲区内存
 class MessageBuffer
 {
 public:
-    MessageBuffer() : rpos_(0), wpos_(0)
+    // Recv 溢出区（scratch）的大小
+    static constexpr std::size_t kExtraBufferSize = 65536;
+    static constexpr std::size_t kInitialSize = 4096;
+    static constexpr std::size_t kMaxReadHint = 256 * 1024;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    MessageBuffer() : data_(nullptr), capacity_(0), pool_(nullptr), rpos_(0), wpos_(0), scanned_(0)
+    {
+    }
+
+    explicit MessageBuffer(std::size_t size) : MessageBuffer()
     {
-        buffer_.resize(4096); // Initial size
+        if (size > 0)
+        {
+            Reallocate(size);
+        }
     }
 
-    explicit MessageBuffer(std::size_t size) : rpos_(0), wpos_(0)
+    explicit MessageBuffer(BufferPool *pool) : MessageBuffer()
     {
-        buffer_.resize(size);
+        pool_ = pool;
+    }
+
+    ~MessageBuffer()
+    {
+        Deallocate();
     }
 
     // 不允许拷贝
@@ -26,43 +59,66 @@ public:
 
     // 允许移动
     MessageBuffer(MessageBuffer &&other) noexcept
-        : buffer_(std::move(other.buffer_)), rpos_(other.rpos_), wpos_(other.wpos_)
+        : data_(other.data_), capacity_(other.capacity_), pool_(other.pool_), rpos_(other.rpos_), wpos_(other.wpos_),
+          scanned_(other.scanned_), scan_delimiter_(std::move(other.scan_delimiter_))
     {
+        read_hint_ = other.read_hint_;
+        small_reads_ = other.small_reads_;
+        other.data_ = nullptr;
+        other.capacity_ = 0;
         other.rpos_ = 0;
         other.wpos_ = 0;
+        other.scanned_ = 0;
     }
 
     MessageBuffer &operator=(MessageBuffer &&other) noexcept
     {
         if (this != &other)
         {
-            buffer_ = std::move(other.buffer_);
+            Deallocate();
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            pool_ = other.pool_;
             rpos_ = other.rpos_;
             wpos_ = other.wpos_;
+            scanned_ = other.scanned_;
+            scan_delimiter_ = std::move(other.scan_delimiter_);
+            read_hint_ = other.read_hint_;
+            small_reads_ = other.small_reads_;
+            other.data_ = nullptr;
+            other.capacity_ = 0;
             other.rpos_ = 0;
             other.wpos_ = 0;
+            other.scanned_ = 0;
         }
         return *this;
     }
 
     uint8_t *GetBasePointer()
     {
-        return buffer_.data();
+        return data_;
     }
 
     uint8_t *GetReadPointer()
     {
-        return buffer_.data() + rpos_;
+        return data_ + rpos_;
     }
 
     uint8_t *GetWritePointer()
     {
-        return buffer_.data() + wpos_;
+        return data_ + wpos_;
     }
 
     void ReadCompleted(std::size_t size)
     {
         rpos_ += size;
+        scanned_ = scanned_ > size ? scanned_ - size : 0;
+        // 读空后回到起点，省掉以后的 Normalize；内存内容不变，刚取出的数据在下次写入前仍然有效
+        if (rpos_ == wpos_)
+        {
+            rpos_ = 0;
+            wpos_ = 0;
+        }
     }
 
     void WriteCompleted(std::size_t size)
@@ -77,19 +133,19 @@ public:
 
     std::size_t GetFreeSize() const
     {
-        return buffer_.size() - wpos_;
+        return capacity_ - wpos_;
     }
 
     std::size_t GetBufferSize() const
     {
-        return buffer_.size();
+        return capacity_;
     }
 
     void Normalize()
     {
         if (rpos_ > 0)
         {
-            std::memmove(buffer_.data(), buffer_.data() + rpos_, GetActiveSize());
+            std::memmove(data_, data_ + rpos_, GetActiveSize());
             wpos_ -= rpos_;
             rpos_ = 0;
         }
@@ -99,8 +155,9 @@ public:
     {
         if (GetBufferSize() - GetActiveSize() < size)
         {
-            Normalize();
-            buffer_.resize(buffer_.size() + std::max(size, buffer_.size() / 2));
+            // 换到更大的块时只拷贝有效数据，顺带完成 Normalize
+            std::size_t capacity = capacity_ == 0 ? std::max(size, kInitialSize) : capacity_ + std::max(size, capacity_ / 2);
+            Reallocate(capacity);
         }
         else if (GetFreeSize() < size)
         {
@@ -108,6 +165,23 @@ public:
         }
     }
 
+    // 数据读空时释放存储（借自池的还给池）；数据远小于容量时换到更小的块
+    void Shrink()
+    {
+        std::size_t active_size = GetActiveSize();
+        if (active_size == 0)
+        {
+            Deallocate();
+            rpos_ = 0;
+            wpos_ = 0;
+            return;
+        }
+        if (capacity_ > kInitialSize && active_size * 4 <= capacity_)
+        {
+            Reallocate(std::max(active_size * 2, kInitialSize));
+        }
+    }
+
     // windows iocp  boost.asio
     void Write(const uint8_t *data, std::size_t size)
     {
@@ -127,30 +201,95 @@ public:
     // 获取第一个 \r\n 之前的数据的指针和大小（若未找到返回nullptr和0）
     std::pair<uint8_t *, std::size_t> GetDataUntilCRLF()
     {
-        uint8_t *data = GetReadPointer();
+        std::size_t pos = Find("\r\n");
+        if (pos == npos)
+        {
+            return {nullptr, 0}; // 未找到
+        }
+        return {GetReadPointer(), pos}; // 数据长度为pos，不包含\r\n
+    }
+
+    // 查找 delimiter（单字节或多字节）第一次出现的位置（相对读指针），未找到返回 npos
+    // 记住已扫描过的位置：一行数据分多次到达时，每次只扫描新到的部分，而不是从读指针重新扫描
+    std::size_t Find(std::string_view delimiter)
+    {
+        if (delimiter.empty())
+        {
+            return 0;
+        }
+        if (delimiter != scan_delimiter_)
+        {
+            scan_delimiter_.assign(delimiter.data(), delimiter.size());
+            scanned_ = 0;
+        }
+
         std::size_t active_size = GetActiveSize();
-        for (std::size_t i = 0; i < active_size - 1; ++i)
+        if (active_size < delimiter.size())
         {
-            if (data[i] == '\r' && data[i + 1] == '\n')
-            {
-                return {data, i}; // 数据长度为i，不包含\r\n
-            }
+            return npos;
+        }
+        const uint8_t *data = GetReadPointer();
+        std::size_t pos = Search(data + scanned_, active_size - scanned_,
+                                 reinterpret_cast<const uint8_t *>(delimiter.data()), delimiter.size());
+        if (pos != npos)
+        {
+            return scanned_ + pos;
+        }
+        // 末尾 delimiter.size() - 1 字节可能是被截断的 delimiter 的前半部分，下次要重新检查
+        scanned_ = active_size - delimiter.size() + 1;
+        return npos;
+    }
+
+    // 读指针到第一个 delimiter 之前的数据，不拷贝，未找到返回 std::nullopt
+    // 不移动读指针，调用方处理完后 ReadCompleted(line.size() + delimiter.size())
+    std::optional<std::string_view> PeekUntil(std::string_view delimiter)
+    {
+        std::size_t pos = Find(delimiter);
+        if (pos == npos)
+        {
+            return std::nullopt;
         }
-        return {nullptr, 0}; // 未找到
+        return std::string_view(reinterpret_cast<const char *>(GetReadPointer()), pos);
+    }
+
+    // 自适应读取：按最近的读取量预留空间，数据直接读进本缓冲区；读满就加倍，连续两次不到一半就减半
+    void SetAdaptiveRead(bool on)
+    {
+        read_hint_ = on ? kInitialSize : 0;
+        small_reads_ = 0;
+    }
+
+    std::size_t GetReadHint() const
+    {
+        return read_hint_;
     }
 
     // linux reactor readv
     // 1. 尽可能的不腾挪数据
-    // 2. 避免了每次都从栈上拷贝到堆上
-    int Recv(int fd, int *err)
+    // 2. 放不下的部分读入 scratch：同一 loop 上的连接共用的一块溢出区，不占用栈空间
+    // 3. 本缓冲区原本没有空间（读空后已 Shrink）且读到的数据较多时，直接与 scratch 交换存储，不拷贝
+    // requested 返回本次最多可读的字节数，读到的少于它说明内核缓冲区已读空
+    int Recv(int fd, int *err, MessageBuffer &scratch, std::size_t *requested = nullptr)
     {
-        char extra[65535]; // 65535
+        if (read_hint_ > 0)
+        {
+            EnsureFreeSpace(read_hint_);
+        }
+        if (scratch.GetBufferSize() < kExtraBufferSize)
+        {
+            scratch.Reallocate(kExtraBufferSize);
+        }
+        std::size_t free_size = GetFreeSize();
         struct iovec iov[2];
         iov[0].iov_base = GetWritePointer();
-        iov[0].iov_len = GetFreeSize();
-        iov[1].iov_base = extra;
-        iov[1].iov_len = sizeof(extra);
-        std::size_t n = readv(fd, iov, 2);
+        iov[0].iov_len = free_size;
+        iov[1].iov_base = scratch.GetBasePointer();
+        iov[1].iov_len = scratch.GetBufferSize();
+        if (requested)
+        {
+            *requested = free_size + scratch.GetBufferSize();
+        }
+        ssize_t n = readv(fd, iov, 2);
         if (n < 0)
         {
             *err = errno;
@@ -161,23 +300,169 @@ public:
             *err = ECONNRESET;
             return 0;
         }
-        else if (n <= GetFreeSize())
+
+        AdjustReadHint(n);
+        if (static_cast<std::size_t>(n) <= free_size)
         {
             WriteCompleted(n);
             return n;
         }
+        std::size_t extra_size = n - free_size;
+        WriteCompleted(free_size);
+        if (GetActiveSize() == 0 && extra_size > kInitialSize && pool_ == scratch.pool_)
+        {
+            // 指针交接：scratch 的块连同数据交给本缓冲区，scratch 换成本缓冲区原来的（空）块，下次读取前再补齐
+            std::swap(data_, scratch.data_);
+            std::swap(capacity_, scratch.capacity_);
+            rpos_ = 0;
+            wpos_ = extra_size;
+            scanned_ = 0;
+        }
         else
         {
-            // WRN: GetfreeSize() 在 WriteCompleted() 中会被更新, extra_size 需要提前计算
-            std::size_t extra_size = n - GetFreeSize();
-            WriteCompleted(GetFreeSize());
-            Write(reinterpret_cast<uint8_t *>(extra), extra_size);
-            return n;
+            Write(scratch.GetBasePointer(), extra_size);
         }
+        return n;
+    }
+
+    // 不指定 scratch 时使用线程局部的溢出区
+    int Recv(int fd, int *err)
+    {
+        static thread_local MessageBuffer scratch(kExtraBufferSize);
+        return Recv(fd, err, scratch);
     }
 
 private:
-    std::vector<uint8_t> buffer_;
+    // 在 [data, data + size) 中查找 delim 第一次出现的位置，未找到返回 npos
+    // 向量化时同时比较 delim 的首字节与末字节，两者都匹配的候选位置才用 memcmp 比较中间部分
+    static std::size_t Search(const uint8_t *data, std::size_t size, const uint8_t *delim, std::size_t delim_size)
+    {
+        if (size < delim_size)
+        {
+            return npos;
+        }
+        std::size_t end = size - delim_size + 1; // 可能的起点为 [0, end)
+        std::size_t middle = delim_size > 2 ? delim_size - 2 : 0;
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i first = _mm256_set1_epi8(static_cast<char>(delim[0]));
+        const __m256i last = _mm256_set1_epi8(static_cast<char>(delim[delim_size - 1]));
+        for (; i + 32 <= end; i += 32)
+        {
+            __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + delim_size - 1));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+            while (mask != 0)
+            {
+                std::size_t pos = i + __builtin_ctz(mask);
+                if (std::memcmp(data + pos + 1, delim + 1, middle) == 0)
+                {
+                    return pos;
+                }
+                mask &= mask - 1;
+            }
+        }
+#elif defined(__SSE2__)
+        const __m128i first = _mm_set1_epi8(static_cast<char>(delim[0]));
+        const __m128i last = _mm_set1_epi8(static_cast<char>(delim[delim_size - 1]));
+        for (; i + 16 <= end; i += 16)
+        {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + delim_size - 1));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+            while (mask != 0)
+            {
+                std::size_t pos = i + __builtin_ctz(mask);
+                if (std::memcmp(data + pos + 1, delim + 1, middle) == 0)
+                {
+                    return pos;
+                }
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            if (data[i] == delim[0] && std::memcmp(data + i + 1, delim + 1, delim_size - 1) == 0)
+            {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    // 换到至少 capacity 字节的新块，有效数据移到块首
+    void Reallocate(std::size_t capacity)
+    {
+        uint8_t *data = pool_ ? pool_->Acquire(&capacity) : static_cast<uint8_t *>(std::malloc(capacity));
+        if (data == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        std::size_t active_size = GetActiveSize();
+        if (active_size > 0)
+        {
+            std::memcpy(data, data_ + rpos_, active_size);
+        }
+        Deallocate();
+        data_ = data;
+        capacity_ = capacity;
+        rpos_ = 0;
+        wpos_ = active_size;
+    }
+
+    void AdjustReadHint(std::size_t size)
+    {
+        if (read_hint_ == 0)
+        {
+            return;
+        }
+        if (size >= read_hint_)
+        {
+            read_hint_ = std::min(read_hint_ * 2, kMaxReadHint);
+            small_reads_ = 0;
+        }
+        else if (size < read_hint_ / 2)
+        {
+            if (++small_reads_ >= 2)
+            {
+                read_hint_ = std::max(read_hint_ / 2, kInitialSize);
+                small_reads_ = 0;
+            }
+        }
+        else
+        {
+            small_reads_ = 0;
+        }
+    }
+
+    void Deallocate()
+    {
+        if (data_ == nullptr)
+        {
+            return;
+        }
+        if (pool_)
+        {
+            pool_->Release(data_, capacity_);
+        }
+        else
+        {
+            std::free(data_);
+        }
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    uint8_t *data_;
+    std::size_t capacity_;
+    BufferPool *pool_;
     std::size_t rpos_;
     std::size_t wpos_;
+    std::size_t scanned_;           // 相对读指针，此前的位置都不是 scan_delimiter_ 的起点
+    std::string scan_delimiter_;
+    std::size_t read_hint_ = 0;     // 自适应读取时每次预留的空间，0 表示关闭
+    int small_reads_ = 0;           // 连续读到不足 read_hint_ 一半的次数
 };
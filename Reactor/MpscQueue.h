@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// 多生产者单消费者无锁队列
+// 1. 生产者用 CAS 把节点压到链表头部，任意线程可并发 Push，互不加锁
+// 2. 消费者用一次 exchange 取走整条链表，反转成入队顺序后逐个处理：每次整批取出，不与生产者逐个竞争，
+//    处理期间新入队的元素留到下一次
+// 3. Push 返回入队前队列是否为空，调用方可以只在空 -> 非空时唤醒消费者
+// 4. ConsumeAll 中 f 抛出异常时，抛出异常的元素被释放，本批剩余的元素留给下一次 ConsumeAll，
+//    排在之后入队的元素前面，不会泄漏也不会乱序
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : head_(nullptr), unconsumed_(nullptr) {}
+
+    ~MpscQueue()
+    {
+        FreeList(head_.exchange(nullptr, std::memory_order_acquire));
+        FreeList(unconsumed_);
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // 线程安全，返回入队前队列是否为空
+    template <class... Args>
+    bool Push(Args &&...args)
+    {
+        Node *node = new Node(std::forward<Args>(args)...);
+        Node *head = head_.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // 只能由消费者调用：按入队顺序对当前已入队的全部元素调用 f，返回处理的个数
+    template <class F>
+    size_t ConsumeAll(F &&f)
+    {
+        Node *node = head_.exchange(nullptr, std::memory_order_acquire);
+        Node *first = nullptr;
+        while (node)
+        {
+            Node *next = node->next;
+            node->next = first;
+            first = node;
+            node = next;
+        }
+        // 上一次因异常没处理完的元素入队更早，排在前面
+        if (unconsumed_)
+        {
+            Node *tail = unconsumed_;
+            while (tail->next)
+            {
+                tail = tail->next;
+            }
+            tail->next = first;
+            first = unconsumed_;
+            unconsumed_ = nullptr;
+        }
+
+        size_t count = 0;
+        while (first)
+        {
+            Node *next = first->next;
+            try
+            {
+                f(first->value);
+            }
+            catch (...)
+            {
+                delete first;
+                unconsumed_ = next;
+                throw;
+            }
+            delete first;
+            first = next;
+            count++;
+        }
+        return count;
+    }
+
+    // 只能由消费者调用
+    bool Empty() const
+    {
+        return unconsumed_ == nullptr && head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        template <class... Args>
+        explicit Node(Args &&...args) : value(std::forward<Args>(args)...), next(nullptr) {}
+
+        T value;
+        Node *next;
+    };
+
+    static void FreeList(Node *node)
+    {
+        while (node)
+        {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // 独占缓存行，避免生产者的 CAS 与相邻成员伪共享
+    alignas(64) std::atomic<Node *> head_;
+    // 只由消费者访问：ConsumeAll 因异常中断时本批剩余的元素，已按入队顺序排列
+    alignas(64) Node *unconsumed_;
+};
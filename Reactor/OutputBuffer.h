@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+// 发送队列：由一串数据片组成，用 sendmsg 一次发送多个片（聚集写），部分写入只推进首片的偏移，不搬移数据
+// 1. 拷贝的数据追加到队尾的数据块中，块写满再新建，连续的小应答共用一个块、发送时只占一个 iovec
+// 2. 引用的数据不拷贝：owner 持有引用计数，数据发送完（或连接释放）后才释放；owner 为空表示调用方保证数据一直有效
+// 3. 小于 kCopyThreshold 的引用数据直接拷贝，一个 iovec 加一次引用计数的开销比拷贝几百字节更大
+// 4. 文件片引用 fd 中的一段数据，轮到它时由内核直接发送，不经过用户态：普通文件用 sendfile，
+//    管道、socket 等不能 sendfile 的数据源用 splice 经内部管道转发；部分发送只推进文件片的偏移
+class OutputBuffer
+{
+public:
+    static constexpr std::size_t kBlockSize = 4096;
+    static constexpr std::size_t kCopyThreshold = 512;
+    static constexpr std::size_t kMaxFileChunk = 0x7ffff000;    // sendfile / splice 单次最多传输的字节数
+#ifdef IOV_MAX
+    static constexpr int kMaxIov = IOV_MAX;
+#else
+    static constexpr int kMaxIov = 1024;
+#endif
+
+    OutputBuffer() : size_(0) {}
+
+    ~OutputBuffer()
+    {
+        if (pipe_[0] >= 0)
+        {
+            ::close(pipe_[0]);
+            ::close(pipe_[1]);
+        }
+    }
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    bool Empty() const
+    {
+        return size_ == 0;
+    }
+
+    // 待发送的总字节数
+    std::size_t Size() const
+    {
+        return size_;
+    }
+
+    // 拷贝 data
+    void Append(const char *data, std::size_t size)
+    {
+        if (size == 0)
+            return;
+
+        if (!slices_.empty())
+        {
+            Slice &tail = slices_.back();
+            if (tail.storage)
+            {
+                char *end = const_cast<char *>(tail.data) + tail.size;
+                std::size_t room = tail.storage.get() + tail.capacity - end;
+                if (size <= room)
+                {
+                    std::memcpy(end, data, size);
+                    tail.size += size;
+                    size_ += size;
+                    return;
+                }
+            }
+        }
+
+        Slice slice;
+        slice.capacity = std::max(size, kBlockSize);
+        slice.storage.reset(new char[slice.capacity]);
+        std::memcpy(slice.storage.get(), data, size);
+        slice.data = slice.storage.get();
+        slice.size = size;
+        slices_.push_back(std::move(slice));
+        size_ += size;
+    }
+
+    // 引用 data，不拷贝
+    void Append(const char *data, std::size_t size, std::shared_ptr<const void> owner)
+    {
+        if (size < kCopyThreshold)
+        {
+            Append(data, size);
+            return;
+        }
+
+        Slice slice;
+        slice.data = data;
+        slice.size = size;
+        slice.owner = std::move(owner);
+        slices_.push_back(std::move(slice));
+        size_ += size;
+    }
+
+    // 引用 file_fd 从 offset 开始的 size 字节，不读进内存；不可 seek 的数据源忽略 offset，从当前位置读
+    // owner 保证发送完之前 file_fd 不被关闭，为空时由调用方保证；file_fd 无效时返回 false
+    // 不可 seek 的数据源应设置 O_NONBLOCK，暂时没有数据时 SendTo 以 EAGAIN 返回，GetBlockedSource 给出该 fd
+    bool AppendFile(int file_fd, off_t offset, std::size_t size, std::shared_ptr<const void> owner)
+    {
+        struct stat st;
+        if (size == 0 || ::fstat(file_fd, &st) != 0)
+            return false;
+
+        Slice slice;
+        slice.file_fd = file_fd;
+        slice.offset = offset;
+        slice.seekable = S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+        slice.size = size;
+        slice.owner = std::move(owner);
+        slices_.push_back(std::move(slice));
+        size_ += size;
+        return true;
+    }
+
+    // 上一次 SendTo 因不可 seek 的数据源暂时没有数据而返回 EAGAIN 时为该数据源的 fd，否则为 -1
+    int GetBlockedSource() const
+    {
+        return blocked_source_;
+    }
+
+    // 以一次 sendmsg 发送队首最多 kMaxIov 个内存片（遇到文件片为止）；队首是文件片时只发送这个文件片
+    // attempted 返回本次尝试发送的字节数，返回值同 sendmsg，成功时已从队列中移除发送出去的部分
+    ssize_t SendTo(int fd, std::size_t *attempted)
+    {
+        blocked_source_ = -1;
+        if (!slices_.empty() && slices_.front().file_fd >= 0)
+            return SendFileSlice(fd, attempted);
+
+        struct iovec iov[kMaxIov];
+        int count = 0;
+        std::size_t bytes = 0;
+        for (auto it = slices_.begin(); it != slices_.end() && it->file_fd < 0 && count < kMaxIov; ++it, ++count)
+        {
+            iov[count].iov_base = const_cast<char *>(it->data);
+            iov[count].iov_len = it->size;
+            bytes += it->size;
+        }
+        *attempted = bytes;
+
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            Consume(n);
+        }
+        return n;
+    }
+
+    // 从队首移除 size 字节
+    void Consume(std::size_t size)
+    {
+        size_ -= size;
+        while (size > 0)
+        {
+            Slice &front = slices_.front();
+            if (size < front.size)
+            {
+                if (front.file_fd >= 0)
+                    front.offset += size;
+                else
+                    front.data += size;
+                front.size -= size;
+                return;
+            }
+            size -= front.size;
+            slices_.pop_front();
+        }
+    }
+
+private:
+    struct Slice
+    {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        std::shared_ptr<const void> owner;  // 引用的数据
+        std::unique_ptr<char[]> storage;    // 拷贝的数据
+        std::size_t capacity = 0;           // storage 的容量，队尾块可以继续追加
+        int file_fd = -1;                   // 文件片的数据源，-1 表示内存片
+        off_t offset = 0;                   // 文件片下一个待发送字节的偏移
+        bool seekable = false;              // true 用 sendfile，false 用 splice 经内部管道转发
+    };
+
+    // sendfile / splice 没有 MSG_NOSIGNAL，对端关闭时会向调用线程发送 SIGPIPE：调用期间在本线程屏蔽 SIGPIPE，
+    // 调用产生的 SIGPIPE 在恢复屏蔽字之前取走丢弃；不改动进程的信号处置，调用前就已挂起的 SIGPIPE 原样保留
+    class SigPipeGuard
+    {
+    public:
+        SigPipeGuard()
+        {
+            sigemptyset(&pipe_set_);
+            sigaddset(&pipe_set_, SIGPIPE);
+            sigset_t pending;
+            sigemptyset(&pending);
+            ::sigpending(&pending);
+            was_pending_ = sigismember(&pending, SIGPIPE);
+            ::pthread_sigmask(SIG_BLOCK, &pipe_set_, &old_mask_);
+        }
+
+        ~SigPipeGuard()
+        {
+            int saved_errno = errno;
+            if (!was_pending_)
+            {
+                sigset_t pending;
+                sigemptyset(&pending);
+                if (::sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE))
+                {
+                    struct timespec zero = {0, 0};
+                    ::sigtimedwait(&pipe_set_, nullptr, &zero);
+                }
+            }
+            ::pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+            errno = saved_errno;
+        }
+
+        SigPipeGuard(const SigPipeGuard &) = delete;
+        SigPipeGuard &operator=(const SigPipeGuard &) = delete;
+
+    private:
+        sigset_t pipe_set_;
+        sigset_t old_mask_;
+        bool was_pending_;
+    };
+
+    ssize_t SendFileSlice(int fd, std::size_t *attempted)
+    {
+        Slice &front = slices_.front();
+        ssize_t n;
+        if (front.seekable)
+        {
+            *attempted = std::min(front.size, kMaxFileChunk);
+            off_t offset = front.offset;
+            {
+                SigPipeGuard guard;
+                n = ::sendfile(fd, front.file_fd, &offset, *attempted);
+            }
+            if (n == 0)
+            {
+                // 文件比登记的长度短，剩余数据永远发不出去
+                errno = ENODATA;
+                return -1;
+            }
+        }
+        else
+        {
+            if (pipe_[0] < 0 && ::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) != 0)
+                return -1;
+            // 先把数据源灌进内部管道，再从管道转发给 socket：两步各自的 EAGAIN 分别表示数据源没数据和 socket 发送缓冲区满
+            if (piped_ < front.size)
+            {
+                ssize_t m = ::splice(front.file_fd, nullptr, pipe_[1], nullptr, std::min(front.size - piped_, kMaxFileChunk),
+                                     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (m > 0)
+                {
+                    piped_ += m;
+                }
+                else if (m == 0)
+                {
+                    errno = ENODATA;
+                    return -1;
+                }
+                else if (errno != EAGAIN)
+                {
+                    return -1;
+                }
+                else if (piped_ == 0)
+                {
+                    *attempted = 0;
+                    blocked_source_ = front.file_fd;
+                    return -1;
+                }
+            }
+            *attempted = piped_;
+            {
+                SigPipeGuard guard;
+                n = ::splice(pipe_[0], nullptr, fd, nullptr, piped_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            }
+            if (n > 0)
+                piped_ -= n;
+        }
+        if (n > 0)
+        {
+            Consume(n);
+        }
+        return n;
+    }
+
+    std::deque<Slice> slices_;
+    std::size_t size_;
+    int pipe_[2] = {-1, -1};    // 转发不可 seek 数据源的内部管道，第一次用到时创建
+    std::size_t piped_ = 0;     // 队首文件片已灌进内部管道、尚未发给 socket 的字节数
+    int blocked_source_ = -1;
+};
@@ -7,51 +7,116 @@
 #include <fcntl.h>
 #include <errno.h>
 
-TcpConn::TcpConn(int fd, EventLoop &evloop)
-    : fd_(fd), evloop_(evloop), closed_(false)
+TcpConn::TcpConn(int fd, EventLoop &evloop, bool edge_triggered, size_t io_budget)
+    : fd_(fd), evloop_(evloop), closed_(false), edge_triggered_(edge_triggered),
+      io_budget_(io_budget > 0 ? io_budget : kDefaultIoBudget), input_buffer_(&evloop.GetBufferPool()),
+      peer_shutdown_(false), waiting_source_(-1)
 {
     SetNonBlocking(fd_);
-    io_handler_ = [this, fd](){ HandleIO(fd); };
-    evloop_.AddEvent(fd, EPOLLIN | EPOLLRDHUP, &io_handler_);
+    io_handler_ = [this](uint32_t events){ HandleIO(events); };
+    // 数据源可读的通知是一次性的，loop 已移除本连接的等待
+    source_handler_ = [this](uint32_t) {
+        if (closed_)
+            return;
+        waiting_source_ = -1;
+        EnableWrite();
+        HandleWrite();
+    };
+    // 边沿触发时始终关注 EPOLLOUT，只在由不可写变为可写时通知一次，省去 EnableWrite / DisableWrite 的 epoll_ctl
+    uint32_t events = edge_triggered_ ? (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET) : (EPOLLIN | EPOLLRDHUP);
+    evloop_.AddEvent(fd, events, &io_handler_);
 }
 
 TcpConn::~TcpConn()
 {
+    close_cb_ = nullptr;
     Close();
 }
 
 int TcpConn::Send(const char *data, size_t size)
 {
-    if (closed_ || data == nullptr || size == 0)
+    return SendImpl(data, size, nullptr);
+}
+
+int TcpConn::Send(const char *data, size_t size, std::shared_ptr<const void> owner)
+{
+    return SendImpl(data, size, &owner);
+}
+
+int TcpConn::Send(std::shared_ptr<const std::string> data)
+{
+    if (!data)
+        return -1;
+    const char *ptr = data->data();
+    size_t size = data->size();
+    return Send(ptr, size, std::move(data));
+}
+
+ssize_t TcpConn::SendFile(int fd, off_t offset, size_t len, std::shared_ptr<const void> owner)
+{
+    if (closed_ || fd < 0 || len == 0)
         return -1;
 
-    if (!output_buffer_.empty())
+    // 队列非空时排在后面，由写事件继续发送
+    bool was_empty = output_buffer_.Empty();
+    if (!output_buffer_.AppendFile(fd, offset, len, std::move(owner)))
+        return -1;
+    if (!was_empty)
+        return 0;
+
+    size_t attempted = 0;
+    ssize_t n = output_buffer_.SendTo(fd_, &attempted);
+    if (n < 0)
     {
-        output_buffer_.append(data, size);
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            Close();
+            return n;
+        }
+        if (WaitForSource())
+            return 0;
+        if (closed_)
+            return -1;
+        n = 0;
+    }
+    if (!output_buffer_.Empty())
         EnableWrite();
+    return n;
+}
+
+// owner 为 nullptr 时拷贝，否则引用
+int TcpConn::SendImpl(const char *data, size_t size, std::shared_ptr<const void> *owner)
+{
+    if (closed_ || data == nullptr || size == 0)
+        return -1;
+
+    // 队列非空时写事件已经打开，只需排在后面，保证顺序
+    if (!output_buffer_.Empty())
+    {
+        if (owner)
+            output_buffer_.Append(data, size, std::move(*owner));
+        else
+            output_buffer_.Append(data, size);
         return size;
     }
 
     int n = ::send(fd_, data, size, MSG_NOSIGNAL);
     if (n < 0)
     {
-        if (errno == EAGAIN || errno == EWOULDBLOCK)
-        {
-            output_buffer_.append(data, size);
-            EnableWrite();
-        }
-        else
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
         {
             Close();
+            return n;
         }
+        n = 0;
     }
-    else
+    if (static_cast<size_t>(n) < size)
     {
-        if (n < size)
-        {
-            output_buffer_.append(data + n, size - n);
-            EnableWrite();
-        }
+        if (owner)
+            output_buffer_.Append(data + n, size - n, std::move(*owner));
+        else
+            output_buffer_.Append(data + n, size - n);
+        EnableWrite();
     }
     return n;
 }
@@ -61,44 +126,122 @@ void TcpConn::HandleIO(uint32_t events)
     if (closed_)
         return;
 
+    if (events & EPOLLRDHUP)
+        peer_shutdown_ = true;
     if (events & EPOLLIN)
         HandleRead();
-    if (events & EPOLLOUT)
+    if (!closed_ && (events & EPOLLOUT))
         HandleWrite();
-    if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+    // 对端关闭写方向（EPOLLRDHUP）时 FIN 之前的数据可能还没读完（水平触发每次只读一次，边沿触发可能读满 io_budget 让出），
+    // 随 EPOLLIN 一起报告时交给读取路径，读到 0 时再关闭
+    if (events & (EPOLLERR | EPOLLHUP))
+        Close();
+    else if ((events & EPOLLRDHUP) && !(events & EPOLLIN))
         Close();
 }
 
+// 水平触发每次唤醒只读一次；边沿触发读到 EAGAIN 为止，一次没读满说明内核缓冲区已空，不必再多一次 readv 确认，
+// 但对端已关闭写方向时之后不会再有通知，要一直读到 0 才能发现 FIN
 void TcpConn::HandleRead()
 {
-    int err = 0;
-    int n = input_buffer_.Recv(fd_, &err);
-    if (n > 0)
+    size_t total = 0;
+    bool peer_closed = false;
+    bool yielded = false;
+    while (true)
     {
-        if (read_cb_)
-            read_cb_();
+        size_t requested = 0;
+        int err = 0;
+        int n = input_buffer_.Recv(fd_, &err, evloop_.GetReadScratch(), &requested);
+        if (n > 0)
+        {
+            total += n;
+            if (!edge_triggered_ || (static_cast<size_t>(n) < requested && !peer_shutdown_))
+                break;
+            if (total >= io_budget_)
+            {
+                yielded = true;
+                break;
+            }
+        }
+        else
+        {
+            peer_closed = (n == 0 || (err != EAGAIN && err != EWOULDBLOCK));
+            break;
+        }
     }
-    else if (n == 0 || (n < 0 && (err != EAGAIN && err != EWOULDBLOCK)))
+
+    if (total > 0 && read_cb_)
+        read_cb_();
+    // 读回调处理完的数据不再需要，读空的缓冲区把存储还给池
+    input_buffer_.Shrink();
+    if (peer_closed)
     {
         Close();
     }
+    else if (yielded && !closed_)
+    {
+        // 边沿触发不会再次通知已就绪的数据，自己排到本轮末尾继续读
+        evloop_.QueueInLoop([self = shared_from_this()]() {
+            if (!self->closed_)
+                self->HandleRead();
+        });
+    }
 }
 
 void TcpConn::HandleWrite()
 {
-    int n = ::send(fd_, output_buffer_.data(), output_buffer_.size(), MSG_NOSIGNAL);
-    if (n > 0)
+    // 等待数据源期间 socket 可写也发不出数据
+    if (waiting_source_ >= 0)
+        return;
+
+    size_t total = 0;
+    while (!output_buffer_.Empty())
     {
-        output_buffer_.erase(0, n);
-        if (output_buffer_.empty())
+        size_t attempted = 0;
+        ssize_t n = output_buffer_.SendTo(fd_, &attempted);
+        if (n < 0)
         {
-            DisableWrite();
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                Close();
+            else
+                WaitForSource();
+            return;
         }
+        total += n;
+        // 没写完说明发送缓冲区已满，等下一次可写通知
+        if (!edge_triggered_ || static_cast<size_t>(n) < attempted)
+            break;
+        if (total >= io_budget_ && !output_buffer_.Empty())
+        {
+            evloop_.QueueInLoop([self = shared_from_this()]() {
+                if (!self->closed_)
+                    self->HandleWrite();
+            });
+            return;
+        }
+    }
+
+    if (output_buffer_.Empty())
+    {
+        DisableWrite();
     }
-    else if (n < 0 && (errno != EAGAIN && errno != EWOULDBLOCK))
+}
+
+// 发送队列首部的不可 seek 数据源暂时没有数据：不再关注本连接的可写事件，改为等待数据源可读
+// 数据源无法注册到 loop 上（如已因其他用途注册）时永远等不到通知，关闭连接并返回 false
+bool TcpConn::WaitForSource()
+{
+    int source = output_buffer_.GetBlockedSource();
+    if (source < 0)
+        return false;
+    if (!evloop_.AddSourceWaiter(source, &source_handler_))
     {
         Close();
+        return false;
     }
+    DisableWrite();
+    waiting_source_ = source;
+    return true;
 }
 
 void TcpConn::Close()
@@ -107,17 +250,29 @@ void TcpConn::Close()
         return;
     closed_ = true;
 
+    if (waiting_source_ >= 0)
+    {
+        evloop_.RemoveSourceWaiter(waiting_source_, &source_handler_);
+        waiting_source_ = -1;
+    }
     evloop_.DelEvent(fd_);
     close(fd_);
+
+    if (close_cb_)
+        close_cb_();
 }
 
 void TcpConn::DisableWrite()
 {
+    if (edge_triggered_)
+        return;
     evloop_.ModEvent(fd_, EPOLLIN | EPOLLRDHUP, &io_handler_);
 }
 
 void TcpConn::EnableWrite()
 {
+    if (edge_triggered_)
+        return;
     evloop_.ModEvent(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP, &io_handler_);
 }
 
@@ -137,16 +292,24 @@ void TcpConn::SetNonBlocking(int fd)
 
 std::string TcpConn::GetDataUntilCrLf()
 {
-    auto data = input_buffer_.GetDataUntilCRLF();
-    if (data.first != nullptr)
+    auto line = ReadLine();
+    if (line)
     {
-        std::string result(reinterpret_cast<char *>(data.first), data.second);
-        input_buffer_.ReadCompleted(data.second+2); // 读取 \r\n
-        return result;
+        return std::string(*line);
     }
     return "";
 }
 
+std::optional<std::string_view> TcpConn::ReadLine(std::string_view delimiter)
+{
+    auto line = input_buffer_.PeekUntil(delimiter);
+    if (line)
+    {
+        input_buffer_.ReadCompleted(line->size() + delimiter.size()); // 连同 delimiter 一起读走
+    }
+    return line;
+}
+
 std::string TcpConn::GetAllData()
 {
     auto data = input_buffer_.GetAllData();
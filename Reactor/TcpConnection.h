@@ -1,8 +1,13 @@
 #pragma once
 
 #include "MessageBuffer.h"
+#include "OutputBuffer.h"
 #include <memory>
 #include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
 
 class EventLoop;
 // TCP连接类
@@ -13,37 +18,78 @@ public:
     using ReadCallback = std::function<void()>;
     using CloseCallback = std::function<void()>;
 
-    TcpConn(int fd, EventLoop &evloop);
+    // 单次唤醒默认最多读 / 写的字节数
+    static constexpr size_t kDefaultIoBudget = 256 * 1024;
+
+    // edge_triggered 为 true 时以 EPOLLET 注册：每次唤醒循环读写直到 EAGAIN，
+    // 单次唤醒读或写满 io_budget 字节仍未完成时让出，剩余部分在本轮末尾继续，避免一个大流量连接饿死其他连接
+    TcpConn(int fd, EventLoop &evloop, bool edge_triggered = false, size_t io_budget = kDefaultIoBudget);
 
     ~TcpConn();
 
     void SetReadCallback(ReadCallback cb) { read_cb_ = cb; }
 
+    // 连接关闭（对端关闭或出错）后调用，在连接所属 loop 线程中执行
+    void SetCloseCallback(CloseCallback cb) { close_cb_ = cb; }
+
+    // 按最近的读取量预留读缓冲区，大流量连接的数据直接读进自己的缓冲区，少经过 loop 的溢出区拷贝一次
+    void SetAdaptiveRead(bool on) { input_buffer_.SetAdaptiveRead(on); }
+
     std::string GetAllData();
 
     std::string GetDataUntilCrLf();
 
+    // 取出一行（不含 delimiter），不拷贝：返回的 string_view 指向输入缓冲区，只在本次读回调返回前有效
+    // 没有完整的一行时返回 std::nullopt
+    std::optional<std::string_view> ReadLine(std::string_view delimiter = "\r\n");
+
+    // 未能立即发出的部分拷贝进发送队列
     int Send(const char* data, size_t size);
 
+    // 不拷贝：未能立即发出的部分在发送队列中引用 data，由 owner 保证发送完之前 data 有效；
+    // owner 为空时由调用方保证（如静态数据）
+    int Send(const char* data, size_t size, std::shared_ptr<const void> owner);
+
+    int Send(std::shared_ptr<const std::string> data);
+
+    // 零拷贝发送 fd 从 offset 开始的 len 字节，排在已提交的数据之后；普通文件用 sendfile，管道、socket 等用 splice
+    // 不可 seek 的数据源忽略 offset 且应设置 O_NONBLOCK，没有数据时转而等待它可读（它不能已因其他用途注册在本连接的 loop 上，
+    // 同一 loop 上的多个连接可以同时等待同一个数据源，数据按各自读到的先后分给它们）
+    // owner 保证发送完之前 fd 不被关闭，为空时由调用方保证；数据源比 len 短时关闭连接
+    // 返回立即发出的字节数，出错返回 -1
+    ssize_t SendFile(int fd, off_t offset, size_t len, std::shared_ptr<const void> owner = nullptr);
+
+    // 连接所属的 loop：其他线程（如 ThreadPool 的工作线程）通过 GetLoop().RunInLoop 把 Send 交回 loop 线程执行
+    EventLoop &GetLoop() { return evloop_; }
+
 private:
     static void SetNonBlocking(int fd);
     void Close();
 
 private:
+    int SendImpl(const char* data, size_t size, std::shared_ptr<const void>* owner);
+
     void HandleIO(uint32_t events);
 
     void HandleRead();
 
     void HandleWrite();
-    
+    bool WaitForSource();
+
     void DisableWrite();
     void EnableWrite();
 
     int fd_;
     EventLoop &evloop_;
     bool closed_;
-    std::string output_buffer_;
+    bool edge_triggered_;
+    size_t io_budget_;
+    OutputBuffer output_buffer_;
     MessageBuffer input_buffer_;
     ReadCallback read_cb_;
-    std::function<void()> io_handler_;
+    CloseCallback close_cb_;
+    std::function<void(uint32_t)> io_handler_;
+    bool peer_shutdown_;    // 收到过 EPOLLRDHUP：对端已关闭写方向，读到 0 时关闭连接
+    int waiting_source_;    // 发送队列首部等待中的数据源，-1 表示没有
+    std::function<void(uint32_t)> source_handler_;
 };
\ No newline at end of file
@@ -1,34 +1,133 @@
-
 #include "TcpConnection.h"
 #include "EventLoop.h"
 #include "TcpServer.h"
 #include <iostream>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 
-TcpServer::TcpServer(EventLoop &evloop)
-    : evloop_(evloop), listen_fd_(-1)
+namespace
+{
+// 交给其他 loop 的新连接 fd：任务执行时取走；loop 已退出、任务没执行就被丢弃时随任务关闭
+class PendingFd
+{
+public:
+    explicit PendingFd(int fd) : fd_(fd) {}
+    PendingFd(PendingFd &&other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    PendingFd(const PendingFd &) = delete;
+    PendingFd &operator=(const PendingFd &) = delete;
+
+    ~PendingFd()
+    {
+        if (fd_ != -1)
+            close(fd_);
+    }
+
+    int Release()
+    {
+        int fd = fd_;
+        fd_ = -1;
+        return fd;
+    }
+
+private:
+    int fd_;
+};
+}
+
+TcpServer::TcpServer(EventLoop &evloop, int num_loops, Dispatch dispatch)
+    : evloop_(evloop), num_loops_(num_loops > 0 ? num_loops : 0), dispatch_(dispatch),
+      shared_listen_fd_(-1), total_connections_(0), next_loop_(0)
 {
 }
 
 TcpServer::~TcpServer()
 {
-    if (listen_fd_ != -1)
+    StopLoops();
+    ReleaseListenFd(base_);
+    base_.connections.clear();
+}
+
+// 通知全部 IO 线程退出并等待，已经退出（监听失败或 Run 提前返回）的线程 loop 为空
+void TcpServer::StopLoops()
+{
+    for (auto &ctx : loops_)
     {
-        evloop_.DelEvent(listen_fd_);
-        close(listen_fd_);
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (ctx->loop)
+            ctx->loop->Quit();
+    }
+    for (auto &thread : threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+    loops_.clear();
+
+    if (shared_listen_fd_ != -1)
+    {
+        close(shared_listen_fd_);
+        shared_listen_fd_ = -1;
     }
 }
 
-void TcpServer::Start(uint16_t port, NewConnCallback cb)
+bool TcpServer::Start(uint16_t port, NewConnCallback cb)
 {
     new_conn_cb_ = cb;
-    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
-    if (listen_fd_ == -1)
+    base_.loop = &evloop_;
+
+    // 先建好全部上下文再启动线程（IO 线程会读取 loops_），
+    // 等待每个 IO 线程的 EventLoop（kReusePort 时还有监听 socket）就绪后再返回
+    for (int i = 0; i < num_loops_; i++)
+    {
+        loops_.emplace_back(new LoopContext);
+    }
+    if (!loops_.empty() && dispatch_ == Dispatch::kSharedListener)
+    {
+        shared_listen_fd_ = CreateListenFd(port);
+        if (shared_listen_fd_ == -1)
+        {
+            loops_.clear();
+            std::cerr << "Server failed to start on port " << port << std::endl;
+            return false;
+        }
+    }
+    std::vector<std::future<bool>> started;
+    for (auto &ctx : loops_)
+    {
+        std::promise<bool> promise;
+        started.push_back(promise.get_future());
+        threads_.emplace_back(&TcpServer::ThreadMain, this, std::ref(*ctx), port, std::move(promise));
+    }
+    bool ok = true;
+    for (auto &future : started)
+    {
+        ok &= future.get();
+    }
+
+    if (ok && !LoopsAccept())
+    {
+        ok = Listen(base_, port);
+    }
+    if (!ok)
+    {
+        StopLoops();
+        std::cerr << "Server failed to start on port " << port << std::endl;
+        return false;
+    }
+    std::cout << "Server started on port " << port << " with " << num_loops_ << " IO loops" << std::endl;
+    return true;
+}
+
+int TcpServer::CreateListenFd(uint16_t port) const
+{
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1)
     {
         std::cerr << "socket error: " << errno << std::endl;
-        return;
+        return -1;
     }
 
     sockaddr_in addr{};
@@ -37,47 +136,237 @@ void TcpServer::Start(uint16_t port, NewConnCallback cb)
     addr.sin_port = htons(port);
 
     int opt = 1;
-    if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1)
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1)
     {
         std::cerr << "setsockopt error: " << errno << std::endl;
-        close(listen_fd_);
-        return;
+        close(listen_fd);
+        return -1;
     }
-    if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1)
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1)
     {
         std::cerr << "setsockopt error: " << errno << std::endl;
-        close(listen_fd_);
-        return;
+        close(listen_fd);
+        return -1;
     }
 
-    if (::bind(listen_fd_, (sockaddr *)&addr, sizeof(addr)) == -1)
+    // 缓冲区大小要在 listen 之前设置，accept 出的连接继承，窗口扩大因子在握手时按它协商
+    if (options_.send_buffer > 0 &&
+        setsockopt(listen_fd, SOL_SOCKET, SO_SNDBUF, &options_.send_buffer, sizeof(options_.send_buffer)) == -1)
+    {
+        std::cerr << "setsockopt SO_SNDBUF error: " << errno << std::endl;
+    }
+    if (options_.recv_buffer > 0 &&
+        setsockopt(listen_fd, SOL_SOCKET, SO_RCVBUF, &options_.recv_buffer, sizeof(options_.recv_buffer)) == -1)
+    {
+        std::cerr << "setsockopt SO_RCVBUF error: " << errno << std::endl;
+    }
+
+    if (::bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) == -1)
     {
         std::cerr << "bind error: " << errno << std::endl;
-        close(listen_fd_);
-        return;
+        close(listen_fd);
+        return -1;
     }
 
-    if (::listen(listen_fd_, SOMAXCONN) == -1)
+    if (::listen(listen_fd, SOMAXCONN) == -1)
     {
         std::cerr << "listen error: " << errno << std::endl;
-        close(listen_fd_);
-        return;
+        close(listen_fd);
+        return -1;
+    }
+    return listen_fd;
+}
+
+bool TcpServer::Listen(LoopContext &ctx, uint16_t port)
+{
+    int listen_fd = CreateListenFd(port);
+    if (listen_fd == -1)
+        return false;
+
+    WatchListenFd(ctx, listen_fd, EPOLLIN);
+    return true;
+}
+
+void TcpServer::WatchListenFd(LoopContext &ctx, int listen_fd, uint32_t events)
+{
+    ctx.listen_fd = listen_fd;
+    ctx.spare_fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    ctx.accept_handler = [this, &ctx](uint32_t) { HandleAccept(ctx); };
+    ctx.loop->AddEvent(listen_fd, events, &ctx.accept_handler);
+}
+
+// IO 线程是否自行 accept（否则由 evloop accept 后分发）
+bool TcpServer::LoopsAccept() const
+{
+    return !loops_.empty() && (dispatch_ == Dispatch::kReusePort || dispatch_ == Dispatch::kSharedListener);
+}
+
+void TcpServer::ThreadMain(LoopContext &ctx, uint16_t port, std::promise<bool> started)
+{
+    EventLoop loop(evloop_.UsesTimerFd());
+    {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+        ctx.loop = &loop;
     }
+    if (dispatch_ == Dispatch::kReusePort)
+    {
+        if (!Listen(ctx, port))
+        {
+            DetachLoop(ctx);
+            started.set_value(false);
+            return;
+        }
+    }
+    else if (dispatch_ == Dispatch::kSharedListener)
+    {
+        // EPOLLEXCLUSIVE：新连接到来时只唤醒一个（或少数几个）loop，避免惊群
+        WatchListenFd(ctx, shared_listen_fd_, EPOLLIN | EPOLLEXCLUSIVE);
+    }
+    started.set_value(true);
+
+    loop.Run();
 
-    accept_handler_ = [this](){ HandleAccept(); };
-    evloop_.AddEvent(listen_fd_, EPOLLIN, &accept_handler_);
-    std::cout << "Server started on port " << port << std::endl;
+    // 监听 socket 与连接都在本线程中释放，先于 loop 析构；
+    // 待执行队列中还没执行的任务（及其持有的连接、未接手的新连接 fd）由 loop 析构时在关闭 epoll fd 之前丢弃
+    ReleaseListenFd(ctx);
+    ctx.connections.clear();
+    DetachLoop(ctx);
+}
+
+// loop 即将随 IO 线程退出而析构，之后 StopLoops / 分发新连接不再经 ctx.loop 访问它
+void TcpServer::DetachLoop(LoopContext &ctx)
+{
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    ctx.loop = nullptr;
+}
+
+// 共享的监听 socket 由析构函数关闭
+void TcpServer::ReleaseListenFd(LoopContext &ctx)
+{
+    if (ctx.listen_fd != -1)
+    {
+        ctx.loop->DelEvent(ctx.listen_fd);
+        if (ctx.listen_fd != shared_listen_fd_)
+            close(ctx.listen_fd);
+        ctx.listen_fd = -1;
+    }
+    if (ctx.spare_fd != -1)
+    {
+        close(ctx.spare_fd);
+        ctx.spare_fd = -1;
+    }
+}
+
+// 每次就绪最多 accept accept_batch 个连接，backlog 中剩下的留到下一轮（监听 socket 是水平触发）
+void TcpServer::HandleAccept(LoopContext &ctx)
+{
+    for (int i = 0; i < options_.accept_batch; i++)
+    {
+        int conn_fd = ::accept4(ctx.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (conn_fd == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                if (ShedConnection(ctx))
+                    continue;
+                return;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                std::cerr << "accept4 error: " << errno << std::endl;
+            return;
+        }
+
+        size_t total = total_connections_.fetch_add(1);
+        if (options_.max_connections > 0 && total >= options_.max_connections)
+        {
+            total_connections_--;
+            close(conn_fd);
+            continue;
+        }
+        if (options_.tcp_nodelay)
+        {
+            int opt = 1;
+            setsockopt(conn_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+
+        LoopContext &target = SelectLoop(ctx);
+        target.num_connections++;
+        if (&target == &ctx)
+        {
+            NewConnection(ctx, conn_fd);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(target.mutex);
+            if (target.loop)
+            {
+                target.loop->QueueInLoop([this, &target, fd = PendingFd(conn_fd)]() mutable {
+                    NewConnection(target, fd.Release());
+                });
+            }
+            else
+            {
+                // 目标 IO 线程已经退出
+                target.num_connections--;
+                total_connections_--;
+                close(conn_fd);
+            }
+        }
+    }
+}
+
+// fd 耗尽时监听 socket 一直可读，不处理会让 loop 空转：
+// 先释放预留的 fd，接受一个连接后立即关闭，再重新预留，返回是否成功丢弃了一个连接
+bool TcpServer::ShedConnection(LoopContext &ctx)
+{
+    if (ctx.spare_fd == -1)
+    {
+        std::cerr << "accept4 error: out of file descriptors" << std::endl;
+        return false;
+    }
+    close(ctx.spare_fd);
+    int conn_fd = ::accept4(ctx.listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn_fd != -1)
+        close(conn_fd);
+    ctx.spare_fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return conn_fd != -1;
+}
+
+TcpServer::LoopContext &TcpServer::SelectLoop(LoopContext &acceptor)
+{
+    if (LoopsAccept() || loops_.empty())
+        return acceptor;
+
+    if (dispatch_ == Dispatch::kLeastConnections)
+    {
+        LoopContext *least = loops_[0].get();
+        for (auto &ctx : loops_)
+        {
+            if (ctx->num_connections < least->num_connections)
+                least = ctx.get();
+        }
+        return *least;
+    }
+    return *loops_[next_loop_++ % loops_.size()];
 }
 
-void TcpServer::HandleAccept()
+void TcpServer::NewConnection(LoopContext &ctx, int conn_fd)
 {
-    sockaddr_in client_addr{};
-    socklen_t len = sizeof(client_addr);
-    int conn_fd = ::accept4(listen_fd_, (sockaddr *)&client_addr, &len, SOCK_NONBLOCK);
-    if (conn_fd == -1)
-        return;
+    auto conn = std::make_shared<TcpConn>(conn_fd, *ctx.loop, options_.edge_triggered, options_.io_budget);
+    conn->SetAdaptiveRead(options_.adaptive_read);
+    TcpConn *key = conn.get();
+    ctx.connections.emplace(key, conn);
+    // 关闭回调在连接自己的 HandleIO 中触发，推迟到本轮末尾再释放连接
+    conn->SetCloseCallback([this, &ctx, key]() {
+        ctx.loop->QueueInLoop([this, &ctx, key]() {
+            ctx.connections.erase(key);
+            ctx.num_connections--;
+            total_connections_--;
+        });
+    });
 
-    auto conn = std::make_shared<TcpConn>(conn_fd, evloop_);
     if (new_conn_cb_)
         new_conn_cb_(conn);
 }
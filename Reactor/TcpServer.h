@@ -1,25 +1,92 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 class TcpConn;
 class EventLoop;
 // 服务器类
+// num_loops 为 0 时所有连接都在传入的 evloop 上处理；否则启动 num_loops 个 IO 线程，每个线程运行一个 EventLoop，
+// 连接归属于分到它的 loop，读写、回调与定时器都在该 loop 线程中执行（NewConnCallback 也在该线程中调用）
+// kRoundRobin / kLeastConnections：evloop 负责 accept，按轮询或当前连接数最少把连接分给 IO 线程
+// kReusePort：每个 IO 线程各自创建 SO_REUSEPORT 监听 socket 并自行 accept，由内核分配连接，evloop 不参与
+// kSharedListener：所有 IO 线程以 EPOLLEXCLUSIVE 监听同一个 socket 并自行 accept，新连接只唤醒其中一个 loop
 class TcpServer {
 public:
     using NewConnCallback = std::function<void(std::shared_ptr<TcpConn>)>;
 
-    TcpServer(EventLoop& evloop);
+    enum class Dispatch { kRoundRobin, kLeastConnections, kReusePort, kSharedListener };
+
+    struct Options {
+        int accept_batch = 64;          // 每次监听 socket 就绪最多 accept 的连接数
+        size_t max_connections = 0;     // 同时在线的连接上限，超出的新连接直接关闭，0 表示不限制
+        bool tcp_nodelay = false;
+        int send_buffer = 0;            // SO_SNDBUF / SO_RCVBUF，设置在监听 socket 上由新连接继承，0 表示系统默认
+        int recv_buffer = 0;
+        bool edge_triggered = false;    // 见 SetEdgeTriggered
+        size_t io_budget = 0;
+        bool adaptive_read = false;     // 见 TcpConn::SetAdaptiveRead
+    };
+
+    TcpServer(EventLoop& evloop, int num_loops = 0, Dispatch dispatch = Dispatch::kRoundRobin);
     ~TcpServer();
 
-    void Start(uint16_t port, NewConnCallback cb);
+    // 返回是否开始监听；失败时已启动的 IO 线程全部退出
+    bool Start(uint16_t port, NewConnCallback cb);
+
+    // 以下设置需在 Start 之前调用
+    void SetOptions(const Options& options) { options_ = options; }
+
+    // 新连接以 EPOLLET 注册，io_budget 为单次唤醒最多读 / 写的字节数，0 表示默认值
+    void SetEdgeTriggered(bool on, size_t io_budget = 0)
+    {
+        options_.edge_triggered = on;
+        options_.io_budget = io_budget;
+    }
+
+    size_t GetConnectionCount() const { return total_connections_; }
 
 private:
-    void HandleAccept() ;
+    // 每个 loop 的上下文，connections 只在该 loop 线程中访问
+    struct LoopContext {
+        // IO 线程的 loop 在该线程栈上，线程退出前置空；其他线程经 loop 调用 Quit / QueueInLoop 时持 mutex
+        std::mutex mutex;
+        EventLoop* loop = nullptr;
+        int listen_fd = -1;
+        int spare_fd = -1;      // 预留的空闲 fd，fd 耗尽时用来接受并关闭连接
+        std::function<void(uint32_t)> accept_handler;
+        std::unordered_map<TcpConn*, std::shared_ptr<TcpConn>> connections;
+        std::atomic<size_t> num_connections{0};
+    };
+
+    int CreateListenFd(uint16_t port) const;
+    bool Listen(LoopContext& ctx, uint16_t port);
+    void WatchListenFd(LoopContext& ctx, int listen_fd, uint32_t events);
+    bool LoopsAccept() const;
+    void ThreadMain(LoopContext& ctx, uint16_t port, std::promise<bool> started);
+    void DetachLoop(LoopContext& ctx);
+    void StopLoops();
+    void HandleAccept(LoopContext& ctx);
+    bool ShedConnection(LoopContext& ctx);
+    void ReleaseListenFd(LoopContext& ctx);
+    LoopContext& SelectLoop(LoopContext& acceptor);
+    void NewConnection(LoopContext& ctx, int conn_fd);
 
     EventLoop& evloop_;
-    int listen_fd_;
+    int num_loops_;
+    Dispatch dispatch_;
+    Options options_;
+    int shared_listen_fd_;
+    std::atomic<size_t> total_connections_;
     NewConnCallback new_conn_cb_;
-    std::function<void()> accept_handler_;
+    LoopContext base_;
+    std::vector<std::unique_ptr<LoopContext>> loops_;
+    std::vector<std::thread> threads_;
+    size_t next_loop_;
 };
@@ -1,27 +1,190 @@
 #pragma once
 
 // #include <sys/epoll.h>
-// #include <unistd.h>
-#include <map>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 定时器：分层时间轮
+// 1. 时间轮 tick 为 1ms（到期时间本身按微秒记录）；第 0 层 256 个槽，第 1~4 层各 64 个槽，共覆盖 2^32 ms（约 49 天），更远的定时器先挂在最高层
+// 2. 每个槽是侵入式双向链表，AddTimeout / DelTimeout 均为 O(1)
+// 3. 第 0 层转完一圈时，把上一层当前槽的节点按剩余时间重新分配到下层（cascade），逐层向上同理
+// 4. 每个槽对应位图中的一位，推进时直接跳过空槽，处理开销与到期节点数和经过的圈数成正比
+// 5. AddTimeout 返回 TimerId（节点表下标 + 代数）而不是节点指针：节点到期或删除时代数加一，
+//    旧句柄随之失效，DelTimeout 对已到期 / 已删除的句柄安全地返回 false
+// 6. 节点按块（每块 256 个）预分配，释放后挂回空闲链表复用；回调存放在节点内的 InlineCallback 中，
+//    捕获不超过 48 字节时不额外分配内存，稳定运行后添加定时器没有 malloc
+// 7. 微秒精度：同一 tick 内的节点按微秒到期时间判断，当前 tick 只执行已到期的部分；
+//    可选由 timerfd 驱动（TimerFd / ArmTimerFd），按最近到期时间以绝对时间设置，到期时间不变时不做系统调用
+// 8. AddPeriodic 添加周期定时器：按 首次到期时间 + k * interval 的名义时间重新挂回时间轮，不累积漂移，
+//    错过的周期直接跳过；回调中删除自身同样有效
+// 9. slack：允许在 [到期时间, 到期时间 + slack] 内任意时刻触发，实际触发时间取该区间内低位 0 最多的时刻
+//    （同 Linux 的 apply_slack），相近的定时器因此落到同一时刻，合并为一次唤醒
+
+// 只可移动的回调：不超过 kInlineSize 字节且可 noexcept 移动的可调用对象直接构造在内部缓冲区，否则放到堆上
+template<class Signature>
+class InlineCallback;
+
+template<class R, class... Args>
+class InlineCallback<R(Args...)> {
+public:
+    static constexpr size_t kInlineSize = 48;
+
+    InlineCallback() noexcept : ops_(nullptr) {}
+
+    template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineCallback>>>
+    InlineCallback(F&& f) : ops_(nullptr) {
+        Emplace(std::forward<F>(f));
+    }
+
+    InlineCallback(InlineCallback&& other) noexcept : ops_(other.ops_) {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InlineCallback& operator=(InlineCallback&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_) {
+                ops_->move(storage_, other.storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineCallback(const InlineCallback&) = delete;
+    InlineCallback& operator=(const InlineCallback&) = delete;
+
+    ~InlineCallback() {
+        reset();
+    }
+
+    template<class F>
+    void Emplace(F&& f) {
+        using Fn = std::decay_t<F>;
+        reset();
+        if constexpr (kFitsInline<Fn>) {
+            new (storage_) Fn(std::forward<F>(f));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    R operator()(Args... args) {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void*, Args&&...);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template<class Fn>
+    static constexpr bool kFitsInline = sizeof(Fn) <= kInlineSize &&
+                                        alignof(Fn) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<Fn>;
+
+    template<class Fn>
+    static constexpr Ops kInlineOps = {
+        [](void* p, Args&&... args) -> R { return (*static_cast<Fn*>(p))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template<class Fn>
+    static constexpr Ops kHeapOps = {
+        [](void* p, Args&&... args) -> R { return (**static_cast<Fn**>(p))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_;
+};
+
+struct TimerId {
+    uint32_t index = 0;         // 在节点表中的下标
+    uint32_t generation = 0;    // 分配时的代数，0 表示无效句柄
+};
 
 class TimerNode {
 public:
     friend class Timer;
-    TimerNode(uint64_t timeout, std::function<void()> callback)
-        : timeout_(timeout), callback_(std::move(callback)) {}
+    TimerNode() : timeout_(0), deadline_(0), interval_(0), slack_(0),
+                  slot_(kNoSlot), index_(0), generation_(1), prev_(nullptr), next_(nullptr) {}
 private:
-    int id;
-    uint64_t timeout_;
-    std::function<void()> callback_;
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+    static constexpr uint32_t kRunningSlot = UINT32_MAX - 1;   // 周期定时器正在执行回调
+
+    uint64_t timeout_;      // 实际触发时间（微秒），即 deadline_ 加上 slack 调整
+    uint64_t deadline_;     // 名义到期时间（微秒）
+    uint64_t interval_;     // 周期（微秒），0 表示一次性定时器
+    uint64_t slack_;        // 允许推迟触发的时长（微秒）
+    InlineCallback<void()> callback_;
+    uint32_t slot_;         // 所在槽位，kNoSlot 表示不在时间轮上（已到期或已删除）
+    uint32_t index_;        // 在节点池中的下标
+    uint32_t generation_;   // 每次到期或删除时加一，与 TimerId 比对
+    TimerNode* prev_;       // 时间轮槽位内的双向链表
+    TimerNode* next_;       // 空闲时复用为空闲链表指针
 };
 
 class Timer {
 public:
+    Timer() = default;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    Timer(Timer&&) = delete;
+    Timer& operator=(Timer&&) = delete;
+    ~Timer() {
+        if (timer_fd_ != -1) {
+            ::close(timer_fd_);
+        }
+    }
+
+    // 当前线程的定时器：EventLoop 在所属线程中把自己的定时器设为当前定时器，
+    // 没有 EventLoop 的线程使用一个线程局部的默认实例。Timer 本身不加锁，只能在所属线程使用
     static Timer* GetInstance() {
-        static Timer instance;
-        return &instance;
+        Timer*& current = Current();
+        if (!current) {
+            static thread_local Timer instance;
+            current = &instance;
+        }
+        return current;
+    }
+
+    static void SetInstance(Timer* timer) {
+        Current() = timer;
     }
 
     static uint64_t GetCurrentTime() {
@@ -29,57 +192,416 @@ public:
         return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
     }
 
-    TimerNode* AddTimeout(uint64_t diff, std::function<void()> cb) {
-        auto node  =  new TimerNode(GetCurrentTime() + diff, std::move(cb));
-        if (timer_map_.empty() || node->timeout_ < timer_map_.rbegin()->first) {
-            auto it = timer_map_.insert(std::make_pair(node->timeout_, std::move(node)));
-            return it->second;
-        } else {
-            auto it = timer_map_.emplace_hint(timer_map_.crbegin().base(), std::make_pair(node->timeout_, std::move(node)));
-            return it->second;
-        }
+    // 与 GetCurrentTime 同源（steady_clock，即 CLOCK_MONOTONIC），单位微秒
+    static uint64_t GetCurrentTimeUs() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // diff 毫秒后到期，slack 为允许推迟触发的毫秒数
+    template<class F>
+    TimerId AddTimeout(uint64_t diff, F&& cb, uint64_t slack = 0) {
+        return Schedule(GetCurrentTimeUs() + diff * 1000, 0, slack * 1000, std::forward<F>(cb));
     };
 
-    void DelTimeout(TimerNode* node) {
-        auto it = timer_map_.equal_range(node->timeout_);
-        for (auto iter = it.first; iter != it.second; ++iter) {
-            if (iter->second == node) {
-                timer_map_.erase(iter);
-                break;
+    // 按任意精度的时长添加，例如 AddTimeout(std::chrono::microseconds(500), cb)
+    template<class Rep, class Period, class F>
+    TimerId AddTimeout(std::chrono::duration<Rep, Period> diff, F&& cb,
+                       std::chrono::microseconds slack = std::chrono::microseconds::zero()) {
+        return Schedule(GetCurrentTimeUs() + ToUs(diff), 0, ToUs(slack), std::forward<F>(cb));
+    }
+
+    // 在绝对时间 expire_us（GetCurrentTimeUs 的时间基准）到期
+    template<class F>
+    TimerId AddTimeoutAt(uint64_t expire_us, F&& cb, uint64_t slack_us = 0) {
+        return Schedule(expire_us, 0, slack_us, std::forward<F>(cb));
+    }
+
+    // 周期定时器：每 interval 毫秒触发一次，直到 DelTimeout
+    template<class F>
+    TimerId AddPeriodic(uint64_t interval, F&& cb, uint64_t slack = 0) {
+        uint64_t interval_us = interval == 0 ? 1 : interval * 1000;
+        return Schedule(GetCurrentTimeUs() + interval_us, interval_us, slack * 1000, std::forward<F>(cb));
+    }
+
+    template<class Rep, class Period, class F>
+    TimerId AddPeriodic(std::chrono::duration<Rep, Period> interval, F&& cb,
+                        std::chrono::microseconds slack = std::chrono::microseconds::zero()) {
+        uint64_t interval_us = ToUs(interval) == 0 ? 1 : ToUs(interval);
+        return Schedule(GetCurrentTimeUs() + interval_us, interval_us, ToUs(slack), std::forward<F>(cb));
+    }
+
+    // 删除尚未到期的定时器，O(1)；句柄已失效（已到期或已删除）时返回 false
+    bool DelTimeout(TimerId id) {
+        if (id.index >= chunks_.size() * kChunkSize) {
+            return false;
+        }
+        TimerNode* node = NodeAt(id.index);
+        if (node->generation_ != id.generation || node->slot_ == TimerNode::kNoSlot) {
+            return false;
+        }
+        if (node->slot_ == TimerNode::kRunningSlot) {
+            // 周期定时器在自己的回调中删除自身：只让句柄失效，回调返回后由 RunExpired 回收
+            RetireNode(node);
+            return true;
+        }
+        Unlink(node);
+        RetireNode(node);
+        FreeNode(node);
+        return true;
+    }
+
+    // 删除全部定时器并销毁回调（不执行）：所属 loop 析构前调用，回调捕获的对象（如连接）在 loop 仍有效时释放
+    void Clear() {
+        for (uint32_t slot = 0; slot <= kTotalSlots; slot++) {
+            while (TimerNode* node = slots_[slot]) {
+                Unlink(node);
+                RetireNode(node);
+                FreeNode(node);
             }
         }
     }
 
-    // 
+    // 距最近一个定时器到期的毫秒数，没有定时器时返回 -1
+    // 高层槽位只能给出下界，提前醒来时 HandleTimeout 会完成 cascade，下一轮再给出准确值
     int WaitTime() {
-        auto iter = timer_map_.begin();
-        if (iter == timer_map_.end()) {
+        if (count_ == 0) {
             return -1;
         }
-        uint64_t diff = iter->first - GetCurrentTime();
-        return diff > 0 ? diff : 0;
+        uint64_t next = NextExpireTime();
+        uint64_t now = GetCurrentTimeUs();
+        if (next <= now) {
+            return 0;
+        }
+        // 向上取整，避免提前醒来后空转
+        uint64_t wait = (next - now + 999) / 1000;
+        return wait > INT_MAX ? INT_MAX : static_cast<int>(wait);
     }
 
     void HandleTimeout() {
-        auto iter = timer_map_.begin();
-        while (iter != timer_map_.end() && iter->first <= GetCurrentTime()) {
-            iter->second->callback_();
-            iter = timer_map_.erase(iter); // 删除已处理的定时器
+        Advance(GetCurrentTimeUs());
+    }
+
+    // 以调用方读取的时间处理到期定时器，EventLoop 每轮只读一次时钟
+    void HandleTimeout(uint64_t now_us) {
+        Advance(now_us);
+    }
+
+    // 返回（首次调用时创建）timerfd；注册到 epoll 后可读即表示最近的定时器到期，
+    // 需调用 ReadTimerFd 清除可读状态，再由 HandleTimeout 处理
+    int TimerFd() {
+        if (timer_fd_ == -1) {
+            timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            if (timer_fd_ == -1) {
+                std::cerr << "timerfd_create error: " << errno << std::endl;
+            }
+        }
+        return timer_fd_;
+    }
+
+    void ReadTimerFd() {
+        uint64_t expirations;
+        ::read(timer_fd_, &expirations, sizeof(expirations));
+        // timerfd 为一次性定时，触发后即处于未设置状态
+        armed_us_ = 0;
+    }
+
+    // 按最近的到期时间设置 timerfd（绝对时间）；与已设置的时间相同则不做系统调用
+    void ArmTimerFd() {
+        if (timer_fd_ == -1) {
+            return;
+        }
+        uint64_t next = count_ == 0 ? 0 : NextExpireTime();
+        if (next == armed_us_) {
+            return;
+        }
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(next / 1000000);
+        spec.it_value.tv_nsec = static_cast<long>(next % 1000000) * 1000;
+        if (::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+            std::cerr << "timerfd_settime error: " << errno << std::endl;
+            return;
         }
+        armed_us_ = next;
     }
 private:
-    std::multimap<uint64_t, TimerNode*> timer_map_;
+    static constexpr int kLevels = 5;
+    static constexpr int kLevel0Bits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr uint32_t kLevel0Slots = 1u << kLevel0Bits;
+    static constexpr uint32_t kLevelSlots = 1u << kLevelBits;
+    static constexpr uint32_t kTotalSlots = kLevel0Slots + (kLevels - 1) * kLevelSlots;
+    static constexpr uint32_t kPendingSlot = kTotalSlots;   // 当前 tick 中已到期、等待执行的节点
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kLevel0Bits + (kLevels - 1) * kLevelBits)) - 1;
 
-    Timer() = default;
-    Timer(const Timer&) = delete;
-    Timer& operator=(const Timer&) = delete;
-    Timer(Timer&&) = delete;
-    Timer& operator=(Timer&&) = delete;
-    ~Timer() {
-        for (auto& pair : timer_map_) {
-            delete pair.second;
+    // 第 level 层的起始槽位与该层一个槽覆盖的时间（2^shift ms）
+    static uint32_t LevelOffset(int level) {
+        return level == 0 ? 0 : kLevel0Slots + (level - 1) * kLevelSlots;
+    }
+    static int LevelShift(int level) {
+        return level == 0 ? 0 : kLevel0Bits + (level - 1) * kLevelBits;
+    }
+
+    template<class Rep, class Period>
+    static uint64_t ToUs(std::chrono::duration<Rep, Period> d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+
+    template<class F>
+    TimerId Schedule(uint64_t deadline_us, uint64_t interval_us, uint64_t slack_us, F&& cb) {
+        TimerNode* node = AllocNode();
+        node->deadline_ = deadline_us;
+        node->interval_ = interval_us;
+        node->slack_ = slack_us;
+        node->timeout_ = ApplySlack(deadline_us, slack_us);
+        node->callback_.Emplace(std::forward<F>(cb));
+        Link(node);
+        return TimerId{node->index_, node->generation_};
+    }
+
+    // 在 [expire, expire + slack] 中取低位 0 最多的时刻，相近的到期时间因此对齐到同一时刻
+    static uint64_t ApplySlack(uint64_t expire, uint64_t slack) {
+        if (slack == 0) {
+            return expire;
+        }
+        uint64_t limit = expire + slack;
+        int bit = 63 - __builtin_clzll(expire ^ limit);
+        return limit & ~((uint64_t(1) << bit) - 1);
+    }
+
+    static constexpr uint32_t kChunkBits = 8;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+
+    TimerNode* NodeAt(uint32_t index) {
+        return &chunks_[index >> kChunkBits][index & (kChunkSize - 1)];
+    }
+
+    // 从空闲链表取节点，空闲链表为空时整块分配 kChunkSize 个
+    TimerNode* AllocNode() {
+        if (!free_list_) {
+            uint32_t base = static_cast<uint32_t>(chunks_.size()) * kChunkSize;
+            chunks_.emplace_back(new TimerNode[kChunkSize]);
+            TimerNode* chunk = chunks_.back().get();
+            for (uint32_t i = kChunkSize; i-- > 0;) {
+                chunk[i].index_ = base + i;
+                chunk[i].next_ = free_list_;
+                free_list_ = &chunk[i];
+            }
+        }
+        TimerNode* node = free_list_;
+        free_list_ = node->next_;
+        node->next_ = nullptr;
+        return node;
+    }
+
+    // 使该节点的 TimerId 失效
+    void RetireNode(TimerNode* node) {
+        if (++node->generation_ == 0) {
+            node->generation_ = 1;
+        }
+    }
+
+    // 销毁回调（释放捕获的资源）并放回空闲链表
+    void FreeNode(TimerNode* node) {
+        node->callback_.reset();
+        node->next_ = free_list_;
+        free_list_ = node;
+    }
+
+    void Link(TimerNode* node) {
+        // 已过期的节点放在当前槽，下一次推进时立即执行
+        uint64_t tick = node->timeout_ / 1000;
+        uint64_t expire = tick < current_ ? current_ : tick;
+        uint64_t delta = expire - current_;
+        if (delta > kMaxDelta) {
+            expire = current_ + kMaxDelta;
+            delta = kMaxDelta;
+        }
+        int level = 0;
+        while (level < kLevels - 1 && delta >> LevelShift(level + 1) != 0) {
+            level++;
+        }
+        uint32_t slots = level == 0 ? kLevel0Slots : kLevelSlots;
+        PushSlot(node, LevelOffset(level) + static_cast<uint32_t>((expire >> LevelShift(level)) & (slots - 1)));
+    }
+
+    void PushSlot(TimerNode* node, uint32_t slot) {
+        node->slot_ = slot;
+        node->prev_ = nullptr;
+        node->next_ = slots_[slot];
+        if (slots_[slot]) {
+            slots_[slot]->prev_ = node;
+        }
+        slots_[slot] = node;
+        bitmap_[slot / 64] |= uint64_t(1) << (slot % 64);
+        count_++;
+    }
+
+    void Unlink(TimerNode* node) {
+        uint32_t slot = node->slot_;
+        if (node->prev_) {
+            node->prev_->next_ = node->next_;
+        } else {
+            slots_[slot] = node->next_;
+            if (!slots_[slot]) {
+                bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+            }
+        }
+        if (node->next_) {
+            node->next_->prev_ = node->prev_;
+        }
+        node->slot_ = TimerNode::kNoSlot;
+        node->prev_ = node->next_ = nullptr;
+        count_--;
+    }
+
+    // 在 [begin, end) 中查找第一个非空槽，没有时返回 end
+    uint32_t FindSlot(uint32_t begin, uint32_t end) const {
+        while (begin < end) {
+            uint64_t word = bitmap_[begin / 64] >> (begin % 64);
+            if (word) {
+                uint32_t found = begin + __builtin_ctzll(word);
+                return found < end ? found : end;
+            }
+            begin = (begin / 64 + 1) * 64;
+        }
+        return end;
+    }
+
+    // 把第 level 层 index 槽的节点重新分配到下层，返回 index（为 0 时需继续 cascade 上一层）
+    uint32_t Cascade(int level) {
+        uint32_t index = static_cast<uint32_t>((current_ >> LevelShift(level)) & (kLevelSlots - 1));
+        uint32_t slot = LevelOffset(level) + index;
+        TimerNode* node = slots_[slot];
+        slots_[slot] = nullptr;
+        bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        while (node) {
+            TimerNode* next = node->next_;
+            count_--;
+            Link(node);
+            node = next;
+        }
+        return index;
+    }
+
+    // 推进到 now_us：依次处理 [current_, now_us 所在 tick] 之间的非空槽
+    // now_us 所在的 tick 可能还有未到期的节点，current_ 停在该 tick，下次继续处理
+    void Advance(uint64_t now_us) {
+        uint64_t now = now_us / 1000;
+        while (current_ <= now) {
+            if (count_ == 0) {
+                current_ = now;
+                break;
+            }
+            uint32_t index = static_cast<uint32_t>(current_ & (kLevel0Slots - 1));
+            if (index == 0) {
+                // 停在边界 tick 上时可能重复进入，此时上层对应槽必为空，重复 cascade 无副作用
+                for (int level = 1; level < kLevels && Cascade(level) == 0; level++) {
+                }
+            }
+            if (current_ == now) {
+                RunExpired(index, now_us, now_us);
+                break;
+            }
+            RunExpired(index, UINT64_MAX, now_us);
+            // 跳到下一个非空槽；本圈没有则跳到下一圈起点做 cascade，但不越过 now
+            uint64_t next = current_ + (FindSlot(index + 1, kLevel0Slots) - index);
+            current_ = next < now ? next : now;
         }
     }
+
+    // 执行第 0 层 index 槽中不晚于 due_us 到期的节点，now_us 为当前时间
+    // 先把到期节点移到 pending 槽再逐个执行：回调中删除其他待执行节点同样是 O(1)；
+    // 回调中新增的已到期节点会落回当前槽，因此执行完后要再检查一遍
+    void RunExpired(uint32_t index, uint64_t due_us, uint64_t now_us) {
+        while (true) {
+            TimerNode* node = slots_[index];
+            while (node) {
+                TimerNode* next = node->next_;
+                if (node->timeout_ <= due_us) {
+                    Unlink(node);
+                    PushSlot(node, kPendingSlot);
+                }
+                node = next;
+            }
+            if (!slots_[kPendingSlot]) {
+                break;
+            }
+            while (TimerNode* expired = slots_[kPendingSlot]) {
+                Unlink(expired);
+                if (expired->interval_ == 0) {
+                    // 回调前先让句柄失效（回调中删除自身会返回 false），回调结束后才放回空闲链表，避免执行中被复用
+                    RetireNode(expired);
+                    expired->callback_();
+                    FreeNode(expired);
+                    continue;
+                }
+                uint32_t generation = expired->generation_;
+                expired->slot_ = TimerNode::kRunningSlot;
+                expired->callback_();
+                if (expired->generation_ != generation) {
+                    FreeNode(expired);  // 回调中被删除
+                    continue;
+                }
+                // 下一个名义到期时间：首次到期时间 + k * interval，且晚于 now_us
+                uint64_t deadline = expired->deadline_ + expired->interval_;
+                if (deadline <= now_us) {
+                    deadline += ((now_us - deadline) / expired->interval_ + 1) * expired->interval_;
+                }
+                expired->deadline_ = deadline;
+                expired->timeout_ = ApplySlack(deadline, expired->slack_);
+                Link(expired);
+            }
+        }
+    }
+
+    // 最近到期时间（微秒）的下界：第 0 层为精确值，高层取对应槽 cascade 的时刻
+    uint64_t NextExpireTime() const {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < kLevels; level++) {
+            int shift = LevelShift(level);
+            uint32_t slots = level == 0 ? kLevel0Slots : kLevelSlots;
+            uint32_t offset = LevelOffset(level);
+            // 本层下一个槽边界（第 0 层即 current_ 本身）
+            uint64_t base = ((current_ + (uint64_t(1) << shift) - 1) >> shift) << shift;
+            uint32_t index = static_cast<uint32_t>((base >> shift) & (slots - 1));
+            uint32_t found = FindSlot(offset + index, offset + slots);
+            uint64_t distance;
+            if (found != offset + slots) {
+                distance = found - offset - index;
+            } else {
+                found = FindSlot(offset, offset + index);
+                if (found == offset + index) {
+                    continue;
+                }
+                distance = found - offset + slots - index;
+            }
+            uint64_t expire = (base + (distance << shift)) * 1000;
+            if (level == 0) {
+                // 第 0 层同一槽内的节点属于同一 tick（或已过期），取其中最早的微秒时间
+                expire = UINT64_MAX;
+                for (TimerNode* node = slots_[found]; node; node = node->next_) {
+                    expire = node->timeout_ < expire ? node->timeout_ : expire;
+                }
+            }
+            next = expire < next ? expire : next;
+        }
+        return next;
+    }
+
+    std::vector<std::unique_ptr<TimerNode[]>> chunks_;   // 节点池，按块分配，地址稳定
+    TimerNode* free_list_ = nullptr;
+    TimerNode* slots_[kTotalSlots + 1] = {};
+    uint64_t bitmap_[kTotalSlots / 64 + 1] = {};
+    uint64_t current_ = GetCurrentTime();  // 下一个待处理的 tick（毫秒）
+    size_t count_ = 0;
+    int timer_fd_ = -1;
+    uint64_t armed_us_ = 0;                 // timerfd 当前设置的到期时间，0 表示未设置
+
+    static Timer*& Current() {
+        static thread_local Timer* current = nullptr;
+        return current;
+    }
 };
 
 #define TimerInstance Timer::GetInstance
@@ -104,11 +626,11 @@ int main() {
         std::cout << "Timeout 2 seconds:" << i++ << std::endl;
     });
 
-    auto node = timer.AddTimeout(3000, [&]() {
+    auto id = timer.AddTimeout(3000, [&]() {
         std::cout << "Timeout 3 seconds:" << i++ << std::endl;
     });
 
-    timer.DelTimeout(node);
+    timer.DelTimeout(id);
 
     epoll_event evs[512];
 
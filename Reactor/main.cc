@@ -1,5 +1,6 @@
 
 #include <iostream>
+#include <thread>
 #include "EventLoop.h"
 #include "TcpServer.h"
 #include "TcpConnection.h"
@@ -7,9 +8,13 @@
 
 int main() {
     EventLoop evloop;
-    TcpServer server(evloop);
+    // 每个核一个 IO loop，主 loop 只负责 accept
+    TcpServer server(evloop, std::thread::hardware_concurrency());
+    TcpServer::Options options;
+    options.tcp_nodelay = true;     // 行协议的小包应答不等 Nagle 合并
+    server.SetOptions(options);
 
-    server.Start(8080, [](TcpConn::Ptr conn) {
+    bool started = server.Start(8080, [](TcpConn::Ptr conn) {
         std::cout << "New connection established\n";
 
         // conn->SetReadCallback([conn]() {
@@ -17,14 +22,20 @@ int main() {
         //     conn->Send("HTTP/1.1 200 OK\r\nContent-Length: 12\r\n\r\nHello World!", 52);
         // });
         conn->SetReadCallback([conn]() {
-            std::cout << "Received: " << conn->GetDataUntilCrLf() << std::endl;
-            conn->Send("Hello World!\r\n", 15);
-            TimerInstance()->AddTimeout(1000, [conn]() {
-                std::cout << "Timeout 1 second\n";
-                conn->Send("Hello after 1 second!\r\n", 24);
-            });
+            // 一次可能读到多行，逐行处理完
+            while (auto line = conn->ReadLine()) {
+                std::cout << "Received: " << *line << std::endl;
+                conn->Send("Hello World!\r\n", 15);
+                TimerInstance()->AddTimeout(1000, [conn]() {
+                    std::cout << "Timeout 1 second\n";
+                    conn->Send("Hello after 1 second!\r\n", 24);
+                });
+            }
         });
     });
+    if (!started) {
+        return 1;
+    }
 
     evloop.Run();
     return 0;
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "MpscQueue.h"
+
+// 辅助打印函数
+void PrintTestResult(const char* test_name, bool passed) {
+    std::cout << test_name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// 统计存活个数，用来确认队列中的元素都被释放
+struct Counted {
+    static int alive;
+    int value;
+
+    explicit Counted(int v) : value(v) { alive++; }
+    ~Counted() { alive--; }
+    Counted(const Counted&) = delete;
+    Counted& operator=(const Counted&) = delete;
+};
+
+int Counted::alive = 0;
+
+// 测试1: 单线程下按入队顺序取出，Push 返回入队前是否为空
+void TestOrder() {
+    MpscQueue<int> queue;
+    bool passed = true;
+
+    passed &= queue.Empty();
+    passed &= queue.Push(1);
+    passed &= !queue.Push(2);
+    passed &= !queue.Push(3);
+    passed &= !queue.Empty();
+
+    std::vector<int> values;
+    passed &= (queue.ConsumeAll([&](int v) { values.push_back(v); }) == 3);
+    passed &= (values == std::vector<int>{1, 2, 3});
+    passed &= queue.Empty();
+    passed &= (queue.ConsumeAll([&](int) { passed = false; }) == 0);
+
+    // 处理期间入队的元素留到下一次
+    queue.Push(4);
+    values.clear();
+    queue.ConsumeAll([&](int v) {
+        values.push_back(v);
+        if (v == 4) {
+            queue.Push(5);
+        }
+    });
+    passed &= (values == std::vector<int>{4});
+    passed &= !queue.Empty();
+    queue.ConsumeAll([&](int v) { values.push_back(v); });
+    passed &= (values == std::vector<int>{4, 5});
+
+    PrintTestResult("TestOrder", passed);
+}
+
+// 测试2: 多生产者并发 Push，消费者同时不断 ConsumeAll：不丢元素，每个生产者的元素保持入队顺序
+void TestMultiProducerStress() {
+    MpscQueue<std::pair<int, int>> queue;
+    bool passed = true;
+
+    const int kProducers = 8;
+    const int kPerProducer = 100000;
+    std::atomic<bool> start(false);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            while (!start.load(std::memory_order_acquire)) {
+            }
+            for (int i = 0; i < kPerProducer; i++) {
+                queue.Push(p, i);
+            }
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    long total = 0;
+    start.store(true, std::memory_order_release);
+    while (total < static_cast<long>(kProducers) * kPerProducer) {
+        total += queue.ConsumeAll([&](const std::pair<int, int>& item) {
+            passed &= (item.second == next[item.first]);
+            next[item.first] = item.second + 1;
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    passed &= (total == static_cast<long>(kProducers) * kPerProducer);
+    for (int p = 0; p < kProducers; p++) {
+        passed &= (next[p] == kPerProducer);
+    }
+    passed &= queue.Empty();
+
+    PrintTestResult("TestMultiProducerStress", passed);
+}
+
+// 测试3: f 抛出异常：抛出异常的元素被释放，本批剩余的元素在下一次 ConsumeAll 中先于新元素处理
+void TestConsumeAllException() {
+    bool passed = true;
+    {
+        MpscQueue<Counted> queue;
+        for (int i = 0; i < 10; i++) {
+            queue.Push(i);
+        }
+        passed &= (Counted::alive == 10);
+
+        std::vector<int> values;
+        bool thrown = false;
+        try {
+            queue.ConsumeAll([&](Counted& c) {
+                if (c.value == 4) {
+                    throw std::runtime_error("functor failed");
+                }
+                values.push_back(c.value);
+            });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        passed &= thrown;
+        passed &= (values == std::vector<int>{0, 1, 2, 3});
+        passed &= (Counted::alive == 5);
+        passed &= !queue.Empty();
+
+        queue.Push(10);
+        values.clear();
+        passed &= (queue.ConsumeAll([&](Counted& c) { values.push_back(c.value); }) == 6);
+        passed &= (values == std::vector<int>{5, 6, 7, 8, 9, 10});
+        passed &= (Counted::alive == 0);
+        passed &= queue.Empty();
+
+        // 剩余元素未再取出时由析构释放
+        for (int i = 0; i < 3; i++) {
+            queue.Push(i);
+        }
+        try {
+            queue.ConsumeAll([&](Counted&) { throw std::runtime_error("functor failed"); });
+        } catch (const std::runtime_error&) {
+        }
+        passed &= (Counted::alive == 2);
+        queue.Push(3);
+    }
+    passed &= (Counted::alive == 0);
+
+    PrintTestResult("TestConsumeAllException", passed);
+}
+
+int main() {
+    TestOrder();
+    TestMultiProducerStress();
+    TestConsumeAllException();
+    std::cout << "\nAll tests completed." << std::endl;
+    return 0;
+}
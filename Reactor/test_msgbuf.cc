@@ -159,6 +159,189 @@ void TestRecvLogic() {
     PrintTestResult("TestRecvLogic", passed);
 }
 
+// 测试7: 查找任意分隔符，数据分多次到达时只扫描新数据
+void TestFindDelimiter() {
+    MessageBuffer buf;
+    bool passed = true;
+
+    // 空缓冲区与数据不足分隔符长度时不越界
+    passed &= (buf.Find("\r\n") == MessageBuffer::npos);
+    passed &= (buf.GetDataUntilCRLF().first == nullptr);
+    buf.Write(reinterpret_cast<const uint8_t*>("\r"), 1);
+    passed &= (buf.Find("\r\n") == MessageBuffer::npos);
+
+    // 分隔符被拆在两次写入之间
+    buf.Write(reinterpret_cast<const uint8_t*>("\n"), 1);
+    passed &= (buf.Find("\r\n") == 0);
+    buf.ReadCompleted(2);
+
+    // 长行分多次到达
+    std::string line(1000, 'a');
+    for (size_t i = 0; i < line.size(); i += 100) {
+        buf.Write(reinterpret_cast<const uint8_t*>(line.data() + i), 100);
+        passed &= (buf.Find("\r\n") == MessageBuffer::npos);
+    }
+    buf.Write(reinterpret_cast<const uint8_t*>("\r\nrest"), 6);
+    auto view = buf.PeekUntil("\r\n");
+    passed &= (view.has_value() && *view == line);
+    buf.ReadCompleted(view->size() + 2);
+    passed &= (!buf.PeekUntil("\r\n").has_value());
+
+    // 单字节、多字节分隔符，以及空行
+    MessageBuffer buf2;
+    buf2.Write(reinterpret_cast<const uint8_t*>("key=value;\n\nEND--END"), 20);
+    passed &= (buf2.Find("=") == 3);
+    passed &= (buf2.Find("\n") == 10);
+    passed &= (buf2.Find("--END") == 15);
+    passed &= (buf2.Find("missing") == MessageBuffer::npos);
+    buf2.ReadCompleted(11);
+    auto empty_line = buf2.PeekUntil("\n");
+    passed &= (empty_line.has_value() && empty_line->empty());
+
+    // 与 std::string::find 对比，覆盖向量化循环与标量收尾的各种边界
+    const char* delimiters[] = {"\n", "\r\n", "\r\n\r\n", "abcab", "xyzxyzxyzxyzxyzxyzxyzxyzxyzxyzxyzxyz"};
+    unsigned seed = 12345;
+    for (const char* delimiter : delimiters) {
+        for (int round = 0; round < 200; round++) {
+            MessageBuffer b(16);
+            std::string data;
+            size_t length = round % 150;
+            for (size_t i = 0; i < length; i++) {
+                seed = seed * 1103515245 + 12345;
+                data.push_back("abcxyz\r\n"[(seed >> 16) % 8]);
+            }
+            // 分成若干段写入，每段之后查找一次，检验记住的扫描位置
+            size_t written = 0;
+            while (written < data.size()) {
+                size_t chunk = std::min<size_t>(data.size() - written, 1 + (seed >> 8) % 37);
+                b.Write(reinterpret_cast<const uint8_t*>(data.data() + written), chunk);
+                written += chunk;
+                size_t expected = data.substr(0, written).find(delimiter);
+                size_t found = b.Find(delimiter);
+                passed &= (expected == std::string::npos ? found == MessageBuffer::npos : found == expected);
+            }
+        }
+    }
+
+    PrintTestResult("TestFindDelimiter", passed);
+}
+
+// 测试8: 从池中借用存储，读空后归还
+void TestPooledBuffer() {
+    BufferPool pool;
+    bool passed = true;
+
+    {
+        MessageBuffer buf(&pool);
+        passed &= (buf.GetBufferSize() == 0);     // 构造时不分配
+
+        int fds[2];
+        pipe(fds);
+        write(fds[1], "hello\r\n", 7);
+        int err = 0;
+        passed &= (buf.Recv(fds[0], &err) == 7);
+        passed &= (buf.GetBufferSize() == MessageBuffer::kInitialSize);
+
+        auto line = buf.PeekUntil("\r\n");
+        passed &= (line.has_value() && *line == "hello");
+        buf.ReadCompleted(line->size() + 2);
+        buf.Shrink();
+        passed &= (buf.GetBufferSize() == 0);
+        passed &= (pool.GetCachedBytes() == MessageBuffer::kInitialSize);
+
+        // 再次读取复用池中的块
+        write(fds[1], "again", 5);
+        passed &= (buf.Recv(fds[0], &err) == 5);
+        passed &= (pool.GetCachedBytes() == 0);
+
+        // 扩容后大小取整到池的级别，数据量降下来后换回小块
+        std::string big(100000, 'x');
+        buf.Write(reinterpret_cast<const uint8_t*>(big.data()), big.size());
+        passed &= (buf.GetBufferSize() == BufferPool::RoundUp(buf.GetBufferSize()));
+        passed &= (buf.GetActiveSize() == 100005);
+        buf.ReadCompleted(100000);
+        buf.Shrink();
+        passed &= (buf.GetBufferSize() == MessageBuffer::kInitialSize);
+        passed &= (memcmp(buf.GetReadPointer(), "xxxxx", 5) == 0);
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+    // 析构时归还
+    passed &= (pool.GetCachedBytes() > 0);
+
+    PrintTestResult("TestPooledBuffer", passed);
+}
+
+// 测试9: 共用溢出区的指针交接与自适应读取
+void TestRecvScratch() {
+    BufferPool pool;
+    bool passed = true;
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int sndbuf = 1 << 20;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    int err = 0;
+    size_t requested = 0;
+
+    {
+        MessageBuffer scratch(&pool);
+        MessageBuffer buf(&pool);
+
+        // 小消息从溢出区拷贝到自己的小块里
+        write(fds[1], "ping\r\n", 6);
+        passed &= (buf.Recv(fds[0], &err, scratch, &requested) == 6);
+        passed &= (requested == MessageBuffer::kExtraBufferSize);
+        passed &= (buf.GetBufferSize() == MessageBuffer::kInitialSize);
+        buf.ReadCompleted(6);
+        buf.Shrink();
+
+        // 空缓冲区读到大块数据时直接接管溢出区的块，不拷贝
+        std::string big(20000, 'y');
+        write(fds[1], big.data(), big.size());
+        uint8_t* scratch_block = scratch.GetBasePointer();
+        passed &= (buf.Recv(fds[0], &err, scratch, &requested) == 20000);
+        passed &= (buf.GetBasePointer() == scratch_block);
+        passed &= (buf.GetActiveSize() == 20000);
+        passed &= (memcmp(buf.GetReadPointer(), big.data(), big.size()) == 0);
+
+        // 已有数据时溢出部分追加在后面
+        write(fds[1], "tail", 4);
+        passed &= (buf.Recv(fds[0], &err, scratch, &requested) == 4);
+        passed &= (buf.GetActiveSize() == 20004);
+        passed &= (memcmp(buf.GetReadPointer() + 20000, "tail", 4) == 0);
+    }
+
+    {
+        MessageBuffer scratch(&pool);
+        MessageBuffer buf(&pool);
+        buf.SetAdaptiveRead(true);
+        passed &= (buf.GetReadHint() == MessageBuffer::kInitialSize);
+
+        // 读满预留空间后加倍，数据直接读进自己的缓冲区
+        std::string chunk(MessageBuffer::kInitialSize, 'z');
+        write(fds[1], chunk.data(), chunk.size());
+        passed &= (buf.Recv(fds[0], &err, scratch, &requested) == static_cast<int>(chunk.size()));
+        passed &= (buf.GetBufferSize() == MessageBuffer::kInitialSize);
+        passed &= (buf.GetReadHint() == 2 * MessageBuffer::kInitialSize);
+        buf.ReadCompleted(buf.GetActiveSize());
+
+        // 连续两次不足一半后减半
+        write(fds[1], "a", 1);
+        buf.Recv(fds[0], &err, scratch, &requested);
+        passed &= (buf.GetReadHint() == 2 * MessageBuffer::kInitialSize);
+        write(fds[1], "b", 1);
+        buf.Recv(fds[0], &err, scratch, &requested);
+        passed &= (buf.GetReadHint() == MessageBuffer::kInitialSize);
+        passed &= (buf.GetActiveSize() == 2);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestRecvScratch", passed);
+}
+
 int main() {
     TestBasicReadWrite();
     TestBufferExpansion();
@@ -166,6 +349,9 @@ int main() {
     TestGetAllData();
     TestGetDataUntilCRLF();
     TestRecvLogic();
+    TestFindDelimiter();
+    TestPooledBuffer();
+    TestRecvScratch();
     std::cout << "\nAll tests completed." << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "OutputBuffer.h"
+
+// 辅助打印函数
+void PrintTestResult(const char* test_name, bool passed) {
+    std::cout << test_name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// 读出 fd 中当前可读的全部数据
+std::string ReadAll(int fd) {
+    std::string result;
+    char tmp[65536];
+    ssize_t n;
+    while ((n = read(fd, tmp, sizeof(tmp))) > 0) {
+        result.append(tmp, n);
+    }
+    return result;
+}
+
+// 测试1: 连续的小块拷贝合并到同一个数据块
+void TestAppendCopy() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    passed &= buf.Empty();
+    buf.Append("Hello ", 6);
+    buf.Append("World", 5);
+    passed &= (buf.Size() == 11);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    size_t attempted = 0;
+    ssize_t n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 11 && attempted == 11);
+    passed &= buf.Empty();
+    passed &= (ReadAll(fds[0]) == "Hello World");
+
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestAppendCopy", passed);
+}
+
+// 测试2: 引用数据不拷贝，发送完才释放引用
+void TestAppendReference() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    auto data = std::make_shared<const std::string>(4096, 'x');
+    buf.Append("head", 4);
+    buf.Append(data->data(), data->size(), data);
+    buf.Append("tail", 4);
+    passed &= (data.use_count() == 2);
+    passed &= (buf.Size() == 4 + 4096 + 4);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    size_t attempted = 0;
+    ssize_t n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 4104 && attempted == 4104);
+    passed &= (data.use_count() == 1);
+    passed &= (ReadAll(fds[0]) == "head" + *data + "tail");
+
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestAppendReference", passed);
+}
+
+// 测试3: 部分写入只推进偏移，剩余数据顺序不变
+void TestPartialWrite() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    int sndbuf = 4096;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    std::string expected;
+    auto big = std::make_shared<const std::string>(1 << 20, 'b');
+    for (int i = 0; i < 1000; i++) {
+        std::string line = "line " + std::to_string(i) + "\r\n";
+        buf.Append(line.data(), line.size());
+        expected += line;
+        if (i % 100 == 0) {
+            buf.Append(big->data(), big->size(), big);
+            expected += *big;
+        }
+    }
+    passed &= (buf.Size() == expected.size());
+
+    std::string received;
+    int rounds = 0;
+    while (!buf.Empty() && rounds < 100000) {
+        size_t attempted = 0;
+        ssize_t n = buf.SendTo(fds[1], &attempted);
+        passed &= (n != 0);
+        if (n < 0) {
+            passed &= (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        received += ReadAll(fds[0]);
+        rounds++;
+    }
+    received += ReadAll(fds[0]);
+    passed &= buf.Empty();
+    passed &= (received == expected);
+    passed &= (big.use_count() == 1);
+
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestPartialWrite", passed);
+}
+
+// 测试4: 片数超过 kMaxIov 时分多次发送
+void TestManySlices() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    auto data = std::make_shared<const std::string>(OutputBuffer::kCopyThreshold, 'r');
+    int count = OutputBuffer::kMaxIov + 10;
+    for (int i = 0; i < count; i++) {
+        buf.Append(data->data(), data->size(), data);
+    }
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    int sndbuf = 4 << 20;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    size_t attempted = 0;
+    ssize_t n = buf.SendTo(fds[1], &attempted);
+    passed &= (attempted == OutputBuffer::kMaxIov * data->size());
+    passed &= (n == static_cast<ssize_t>(attempted));
+    n = buf.SendTo(fds[1], &attempted);
+    passed &= (attempted == 10 * data->size());
+    passed &= buf.Empty();
+    passed &= (ReadAll(fds[0]).size() == count * data->size());
+
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestManySlices", passed);
+}
+
+// 测试5: 文件片用 sendfile 发送，与内存片保持顺序，部分发送后从偏移处继续
+void TestFileSlice() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    std::string content;
+    for (int i = 0; i < 100000; i++) {
+        content += static_cast<char>('a' + i % 26);
+    }
+    FILE* file = tmpfile();
+    fwrite(content.data(), 1, content.size(), file);
+    fflush(file);
+    int file_fd = fileno(file);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    int sndbuf = 4096;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    buf.Append("head", 4);
+    passed &= buf.AppendFile(file_fd, 10, content.size() - 10, nullptr);
+    buf.Append("tail", 4);
+    passed &= (buf.Size() == 4 + content.size() - 10 + 4);
+    passed &= !buf.AppendFile(-1, 0, 10, nullptr);
+
+    // 第一次只发送文件片之前的内存片
+    size_t attempted = 0;
+    ssize_t n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 4 && attempted == 4);
+
+    std::string received = ReadAll(fds[0]);
+    int rounds = 0;
+    while (!buf.Empty() && rounds < 100000) {
+        n = buf.SendTo(fds[1], &attempted);
+        if (n < 0) {
+            passed &= (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        received += ReadAll(fds[0]);
+        rounds++;
+    }
+    received += ReadAll(fds[0]);
+    passed &= buf.Empty();
+    passed &= (received == "head" + content.substr(10) + "tail");
+
+    // 文件比登记的长度短
+    passed &= buf.AppendFile(file_fd, content.size() - 5, 10, nullptr);
+    n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 5);
+    n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == -1 && errno == ENODATA);
+
+    fclose(file);
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestFileSlice", passed);
+}
+
+// 测试6: 不可 seek 的数据源经管道 splice 转发，没有数据时报告等待的数据源
+void TestSpliceSource() {
+    OutputBuffer buf;
+    bool passed = true;
+
+    int source[2];
+    pipe(source);
+    fcntl(source[0], F_SETFL, O_NONBLOCK);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    passed &= buf.AppendFile(source[0], 0, 10, nullptr);
+    size_t attempted = 0;
+    ssize_t n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == -1 && errno == EAGAIN);
+    passed &= (buf.GetBlockedSource() == source[0]);
+
+    write(source[1], "hello", 5);
+    n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 5 && attempted == 5);
+    passed &= (buf.GetBlockedSource() == -1);
+    passed &= (buf.Size() == 5);
+
+    write(source[1], "world", 5);
+    n = buf.SendTo(fds[1], &attempted);
+    passed &= (n == 5);
+    passed &= buf.Empty();
+    passed &= (ReadAll(fds[0]) == "helloworld");
+
+    close(source[0]);
+    close(source[1]);
+    close(fds[0]);
+    close(fds[1]);
+    PrintTestResult("TestSpliceSource", passed);
+}
+
+// 测试7: 对端已关闭时 sendfile / splice 返回 EPIPE，不会以 SIGPIPE 终止进程，也不改动进程的 SIGPIPE 处置和线程的屏蔽字
+void TestPeerClosedNoSigPipe() {
+    bool passed = true;
+
+    struct sigaction sa;
+    sigaction(SIGPIPE, nullptr, &sa);
+    passed &= (sa.sa_handler == SIG_DFL);
+    sigset_t mask_before;
+    pthread_sigmask(SIG_SETMASK, nullptr, &mask_before);
+
+    FILE* file = tmpfile();
+    fwrite("0123456789", 1, 10, file);
+    fflush(file);
+    int source[2];
+    pipe(source);
+    fcntl(source[0], F_SETFL, O_NONBLOCK);
+    write(source[1], "hello", 5);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    close(fds[0]);
+
+    size_t attempted = 0;
+    {
+        OutputBuffer buf;
+        passed &= buf.AppendFile(fileno(file), 0, 10, nullptr);
+        ssize_t n = buf.SendTo(fds[1], &attempted);
+        passed &= (n == -1 && errno == EPIPE);
+    }
+    {
+        OutputBuffer buf;
+        passed &= buf.AppendFile(source[0], 0, 5, nullptr);
+        ssize_t n = buf.SendTo(fds[1], &attempted);
+        passed &= (n == -1 && errno == EPIPE);
+    }
+
+    sigaction(SIGPIPE, nullptr, &sa);
+    passed &= (sa.sa_handler == SIG_DFL);
+    sigset_t mask_after;
+    pthread_sigmask(SIG_SETMASK, nullptr, &mask_after);
+    passed &= (sigismember(&mask_after, SIGPIPE) == sigismember(&mask_before, SIGPIPE));
+    sigset_t pending;
+    sigpending(&pending);
+    passed &= !sigismember(&pending, SIGPIPE);
+
+    fclose(file);
+    close(source[0]);
+    close(source[1]);
+    close(fds[1]);
+    PrintTestResult("TestPeerClosedNoSigPipe", passed);
+}
+
+int main() {
+    TestAppendCopy();
+    TestAppendReference();
+    TestPartialWrite();
+    TestManySlices();
+    TestFileSlice();
+    TestSpliceSource();
+    TestPeerClosedNoSigPipe();
+    std::cout << "\nAll tests completed." << std::endl;
+    return 0;
+}
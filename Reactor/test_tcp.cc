@@ -0,0 +1,628 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include "EventLoop.h"
+#include "TcpConnection.h"
+#include "TcpServer.h"
+
+// 辅助打印函数
+void PrintTestResult(const char* test_name, bool passed) {
+    std::cout << test_name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// 建立一对回环 TCP 连接：client 为阻塞 socket，server 为 accept 出的一端
+// rcvbuf 设置在监听 socket 上由 server 端继承，保证测试数据在开始读之前就能全部放进内核缓冲区
+bool LoopbackPair(int* client, int* server, int rcvbuf = 0) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (rcvbuf > 0) {
+        setsockopt(listen_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == -1 || listen(listen_fd, 1) == -1 ||
+        getsockname(listen_fd, (sockaddr*)&addr, &len) == -1) {
+        close(listen_fd);
+        return false;
+    }
+    *client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (rcvbuf > 0) {
+        setsockopt(*client, SOL_SOCKET, SO_SNDBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    if (connect(*client, (sockaddr*)&addr, sizeof(addr)) == -1) {
+        close(*client);
+        close(listen_fd);
+        return false;
+    }
+    *server = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    close(listen_fd);
+    return *server != -1;
+}
+
+bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// 取一个当前空闲的端口给 TcpServer 监听
+uint16_t FreePort() {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+bool Connect(int fd, uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    timeval timeout{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+}
+
+// 发送 data 并等到服务端原样回显
+bool Echo(int fd, const std::string& data) {
+    if (!SendAll(fd, data)) {
+        return false;
+    }
+    std::string received;
+    char buf[256];
+    while (received.size() < data.size()) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        received.append(buf, n);
+    }
+    return received == data;
+}
+
+// 服务端关闭了连接：读到 EOF 或 RST，超时说明连接仍然开着
+bool PeerClosed(int fd) {
+    char buf[16];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    return n == 0 || (n == -1 && errno == ECONNRESET);
+}
+
+// 等待服务端处理完连接关闭（连接数在 loop 线程中推迟到本轮末尾才减少）
+bool WaitConnectionCount(const TcpServer& server, size_t count) {
+    for (int i = 0; i < 200 && server.GetConnectionCount() != count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return server.GetConnectionCount() == count;
+}
+
+// 回显服务：连接收到什么就发回什么
+void StartEchoServer(TcpServer& server, uint16_t port, int* accepted) {
+    server.Start(port, [accepted](TcpConn::Ptr conn) {
+        TcpConn* raw = conn.get();
+        conn->SetReadCallback([raw]() {
+            std::string data = raw->GetAllData();
+            raw->Send(data.data(), data.size());
+        });
+        (*accepted)++;
+    });
+}
+
+std::string MakePayload(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>(i % 251);
+    }
+    return data;
+}
+
+// 测试1: 对端发送超过 io_budget 的数据后立即 shutdown(SHUT_WR)：
+// EPOLLRDHUP 与数据一起到达，FIN 之前的数据仍要全部交给读回调，读到 0 之后才关闭
+void TestReadBeforePeerShutdown(bool edge_triggered) {
+    EventLoop loop;
+    bool passed = true;
+
+    const size_t kBudget = 16 * 1024;
+    const std::string payload = MakePayload(200 * 1024);
+    int client = -1;
+    int server = -1;
+    passed &= LoopbackPair(&client, &server, 1 << 20);
+
+    // 数据与 FIN 在 loop 开始读之前就已全部到达
+    auto sender = std::async(std::launch::async, [&]() {
+        bool ok = SendAll(client, payload);
+        shutdown(client, SHUT_WR);
+        return ok;
+    });
+    sender.wait_for(std::chrono::seconds(2));
+
+    std::string received;
+    int reads = 0;
+    bool closed = false;
+    auto conn = std::make_shared<TcpConn>(server, loop, edge_triggered, kBudget);
+    TcpConn* raw = conn.get();
+    conn->SetReadCallback([&, raw]() {
+        received += raw->GetAllData();
+        reads++;
+    });
+    conn->SetCloseCallback([&]() {
+        closed = true;
+        loop.Quit();
+    });
+    // 兜底：出错时不至于一直阻塞
+    loop.RunAfter(5000, [&]() { loop.Quit(); });
+    loop.Run();
+
+    passed &= sender.get();
+    passed &= closed;
+    passed &= (received == payload);
+    passed &= (reads > 1);
+
+    close(client);
+    PrintTestResult(edge_triggered ? "TestReadBeforePeerShutdown(ET)" : "TestReadBeforePeerShutdown(LT)", passed);
+}
+
+// 测试2: 边沿触发下大流量连接读满 io_budget 后让出，同一轮就绪的其他连接先得到处理；
+// 之后不会再有新的可读通知，让出的连接靠排到本轮末尾的续读把数据读完
+void TestEdgeTriggeredBudgetYield() {
+    EventLoop loop;
+    bool passed = true;
+
+    const size_t kBudget = 16 * 1024;
+    const std::string payload = MakePayload(200 * 1024);
+    int heavy_client = -1, heavy_server = -1;
+    int light_client = -1, light_server = -1;
+    passed &= LoopbackPair(&heavy_client, &heavy_server, 1 << 20);
+    passed &= LoopbackPair(&light_client, &light_server);
+    passed &= SendAll(heavy_client, payload);
+    passed &= SendAll(light_client, "ping");
+
+    std::string heavy_received;
+    std::string light_received;
+    size_t heavy_when_light = 0;
+    int heavy_reads = 0;
+    auto heavy = std::make_shared<TcpConn>(heavy_server, loop, true, kBudget);
+    auto light = std::make_shared<TcpConn>(light_server, loop, true, kBudget);
+    TcpConn* heavy_raw = heavy.get();
+    TcpConn* light_raw = light.get();
+    heavy->SetReadCallback([&, heavy_raw]() {
+        heavy_received += heavy_raw->GetAllData();
+        heavy_reads++;
+        if (heavy_received.size() == payload.size()) {
+            loop.Quit();
+        }
+    });
+    light->SetReadCallback([&, light_raw]() {
+        light_received += light_raw->GetAllData();
+        heavy_when_light = heavy_received.size();
+    });
+    loop.RunAfter(5000, [&]() { loop.Quit(); });
+    loop.Run();
+
+    passed &= (light_received == "ping");
+    passed &= (heavy_when_light < payload.size());
+    passed &= (heavy_reads > 1);
+    passed &= (heavy_received == payload);
+
+    close(heavy_client);
+    close(light_client);
+    PrintTestResult("TestEdgeTriggeredBudgetYield", passed);
+}
+
+// 测试3: max_connections：超出上限的新连接被直接关闭，已有连接不受影响，有连接关闭后腾出名额
+void TestMaxConnections() {
+    EventLoop loop;
+    bool passed = true;
+
+    TcpServer server(loop);
+    TcpServer::Options options;
+    options.max_connections = 2;
+    server.SetOptions(options);
+    uint16_t port = FreePort();
+    int accepted = 0;
+    StartEchoServer(server, port, &accepted);
+
+    auto client = std::async(std::launch::async, [&]() {
+        int fds[4];
+        for (int& fd : fds) {
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        }
+        bool ok = Connect(fds[0], port) && Echo(fds[0], "first");
+        ok &= Connect(fds[1], port) && Echo(fds[1], "second");
+        ok &= Connect(fds[2], port) && PeerClosed(fds[2]);
+        ok &= Echo(fds[0], "still open");
+        ok &= WaitConnectionCount(server, 2);
+
+        close(fds[0]);
+        fds[0] = -1;
+        ok &= WaitConnectionCount(server, 1);
+        ok &= Connect(fds[3], port) && Echo(fds[3], "fourth");
+        ok &= (server.GetConnectionCount() == 2);
+
+        for (int fd : fds) {
+            close(fd);
+        }
+        loop.Quit();
+        return ok;
+    });
+    loop.RunAfter(10000, [&]() { loop.Quit(); });
+    loop.Run();
+
+    passed &= client.get();
+    passed &= (accepted == 3);
+
+    PrintTestResult("TestMaxConnections", passed);
+}
+
+// 测试4: fd 耗尽（EMFILE）时用预留的 fd 接受并关闭新连接，监听 socket 不会一直就绪让 loop 空转；
+// fd 恢复后照常接受连接
+void TestShedOnFdExhaustion() {
+    EventLoop loop;
+    bool passed = true;
+
+    TcpServer server(loop);
+    uint16_t port = FreePort();
+    int accepted = 0;
+    StartEchoServer(server, port, &accepted);
+
+    rlimit old_limit;
+    getrlimit(RLIMIT_NOFILE, &old_limit);
+    // loop 线程的 CPU 时间：loop 空转时会一直增长
+    clockid_t loop_clock;
+    pthread_getcpuclockid(pthread_self(), &loop_clock);
+    auto client = std::async(std::launch::async, [&]() {
+        // 客户端 socket 先创建好，connect 不再占用 fd
+        int fds[4];
+        for (int& fd : fds) {
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        }
+        // 只留下一个空闲 fd：新 fd 总是取最小的空闲编号
+        int probe = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        close(probe);
+        rlimit limit = old_limit;
+        limit.rlim_cur = probe + 1;
+        setrlimit(RLIMIT_NOFILE, &limit);
+
+        bool ok = Connect(fds[0], port) && Echo(fds[0], "accepted");
+        ok &= Connect(fds[1], port) && PeerClosed(fds[1]);
+        ok &= Connect(fds[2], port) && PeerClosed(fds[2]);
+        ok &= Echo(fds[0], "still open");
+        ok &= (server.GetConnectionCount() == 1);
+        // 被丢弃的连接处理完后 loop 应当空闲下来
+        timespec before, after;
+        clock_gettime(loop_clock, &before);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        clock_gettime(loop_clock, &after);
+        long busy_ms = (after.tv_sec - before.tv_sec) * 1000 + (after.tv_nsec - before.tv_nsec) / 1000000;
+        ok &= (busy_ms < 50);
+
+        setrlimit(RLIMIT_NOFILE, &old_limit);
+        ok &= Connect(fds[3], port) && Echo(fds[3], "after restore");
+        ok &= (server.GetConnectionCount() == 2);
+
+        for (int fd : fds) {
+            close(fd);
+        }
+        loop.Quit();
+        return ok;
+    });
+    loop.RunAfter(10000, [&]() { loop.Quit(); });
+    loop.Run();
+
+    passed &= client.get();
+    passed &= (accepted == 2);
+    setrlimit(RLIMIT_NOFILE, &old_limit);
+
+    PrintTestResult("TestShedOnFdExhaustion", passed);
+}
+
+// 读满 size 字节或对端关闭为止
+std::string RecvAll(int fd, size_t size) {
+    std::string received;
+    char buf[16 * 1024];
+    while (received.size() < size) {
+        ssize_t n = recv(fd, buf, std::min(sizeof(buf), size - received.size()), 0);
+        if (n <= 0) {
+            break;
+        }
+        received.append(buf, n);
+    }
+    return received;
+}
+
+// 测试5: 同一 loop 上的多个连接 SendFile 同一个管道并同时等待它可读：
+// 都能注册等待，其中一个在等待中关闭不影响其他连接，管道中的数据全部发出且不重复
+void TestSharedSource() {
+    EventLoop loop;
+    bool passed = true;
+
+    const size_t kLen = 64 * 1024;
+    int pipe_fds[2];
+    passed &= (pipe2(pipe_fds, O_CLOEXEC) == 0);
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+
+    int clients[3];
+    std::shared_ptr<TcpConn> conns[3];
+    bool closed[3] = {false, false, false};
+    for (int i = 0; i < 3; i++) {
+        int server = -1;
+        passed &= LoopbackPair(&clients[i], &server);
+        timeval timeout{5, 0};
+        setsockopt(clients[i], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        conns[i] = std::make_shared<TcpConn>(server, loop);
+        conns[i]->SetCloseCallback([&closed, i]() { closed[i] = true; });
+        // 管道还是空的，三个连接都转为等待它可读
+        passed &= (conns[i]->SendFile(pipe_fds[0], 0, kLen) == 0);
+    }
+    passed &= !closed[0] && !closed[1] && !closed[2];
+
+    // 第一个连接的对端在等待中关闭：只移除它自己的等待，其余两个仍能收到通知
+    close(clients[0]);
+    const std::string payload = MakePayload(2 * kLen);
+    // 写端非阻塞，数据一直发不出去时放弃，不让测试卡住
+    fcntl(pipe_fds[1], F_SETFL, O_NONBLOCK);
+    auto writer = std::async(std::launch::async, [&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        size_t written = 0;
+        for (int i = 0; i < 5000 && written < payload.size(); i++) {
+            ssize_t n = write(pipe_fds[1], payload.data() + written, payload.size() - written);
+            if (n > 0) {
+                written += n;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return written == payload.size();
+    });
+    auto reader1 = std::async(std::launch::async, [&]() { return RecvAll(clients[1], kLen); });
+    auto reader2 = std::async(std::launch::async, [&]() { return RecvAll(clients[2], kLen); });
+    auto done = std::async(std::launch::async, [&]() {
+        reader1.wait();
+        reader2.wait();
+        loop.Quit();
+    });
+    loop.Run();
+    done.wait();
+
+    std::string received1 = reader1.get();
+    std::string received2 = reader2.get();
+    passed &= writer.get();
+    passed &= closed[0] && !closed[1] && !closed[2];
+    passed &= (received1.size() == kLen && received2.size() == kLen);
+    // 两个连接各自读到的数据交错来自管道，合起来恰好是写入的全部数据
+    std::string all = received1 + received2;
+    std::string expected = payload;
+    std::sort(all.begin(), all.end());
+    std::sort(expected.begin(), expected.end());
+    passed &= (all == expected);
+
+    for (auto& conn : conns) {
+        conn.reset();
+    }
+    close(clients[1]);
+    close(clients[2]);
+
+    // 数据源已因其他用途注册在 loop 上时无法等待，连接关闭而不是永远卡住
+    EventLoop::EventHandler other = [](uint32_t) {};
+    passed &= loop.AddEvent(pipe_fds[0], EPOLLIN, &other);
+    int client = -1;
+    int server = -1;
+    passed &= LoopbackPair(&client, &server);
+    bool conn_closed = false;
+    auto conn = std::make_shared<TcpConn>(server, loop);
+    conn->SetCloseCallback([&]() { conn_closed = true; });
+    passed &= (conn->SendFile(pipe_fds[0], 0, kLen) == -1);
+    passed &= conn_closed;
+    loop.DelEvent(pipe_fds[0]);
+    conn.reset();
+    close(client);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    PrintTestResult("TestSharedSource", passed);
+}
+
+// 测试6: 端口被占用时 Start 返回 false：kReusePort 下 IO 线程的监听失败也要报告出来，已启动的线程全部退出
+void TestStartFailure() {
+    EventLoop loop;
+    bool passed = true;
+
+    // 不带 SO_REUSEPORT 占住端口，服务器的监听 socket 无法再绑定
+    uint16_t port = FreePort();
+    int holder = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    passed &= (bind(holder, (sockaddr*)&addr, sizeof(addr)) == 0 && listen(holder, 1) == 0);
+
+    TcpServer::Dispatch modes[] = {TcpServer::Dispatch::kReusePort, TcpServer::Dispatch::kRoundRobin,
+                                   TcpServer::Dispatch::kSharedListener};
+    for (TcpServer::Dispatch mode : modes) {
+        TcpServer server(loop, 2, mode);
+        passed &= !server.Start(port, nullptr);
+    }
+    TcpServer single(loop);
+    passed &= !single.Start(port, nullptr);
+
+    close(holder);
+    TcpServer server(loop, 2, TcpServer::Dispatch::kReusePort);
+    passed &= server.Start(port, nullptr);
+
+    PrintTestResult("TestStartFailure", passed);
+}
+
+// 测试7: 服务器析构时 IO 线程待执行队列中还没执行的新连接任务被丢弃，连接 fd 随之关闭而不是泄漏
+void TestTeardownPendingConnection() {
+    EventLoop loop;
+    bool passed = true;
+
+    auto server = std::make_unique<TcpServer>(loop, 1);
+    uint16_t port = FreePort();
+    // 第一个连接的回调阻塞住唯一的 IO 线程，第二个连接的 NewConnection 任务只能排在它的待执行队列中
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> callbacks(0);
+    passed &= server->Start(port, [&, released](TcpConn::Ptr) {
+        if (callbacks++ == 0) {
+            released.wait();
+        }
+    });
+
+    int clients[2];
+    for (int& fd : clients) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+    auto client = std::async(std::launch::async, [&]() {
+        bool ok = Connect(clients[0], port);
+        for (int i = 0; i < 200 && callbacks == 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ok &= Connect(clients[1], port);
+        ok &= WaitConnectionCount(*server, 2);
+        loop.Quit();
+        return ok;
+    });
+    loop.Run();
+    passed &= client.get();
+
+    // 析构先通知 IO 线程退出，回调返回后 loop 不再执行第二个连接的任务
+    auto releaser = std::async(std::launch::async, [&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        release.set_value();
+    });
+    server.reset();
+    releaser.wait();
+
+    passed &= (callbacks == 1);
+    passed &= PeerClosed(clients[0]);
+    passed &= PeerClosed(clients[1]);
+
+    close(clients[0]);
+    close(clients[1]);
+    PrintTestResult("TestTeardownPendingConnection", passed);
+}
+
+// 测试8: loop 析构时待执行任务与定时器回调持有的连接在 epoll fd、缓冲块池仍有效时释放
+void TestLoopTeardownReleasesConnections() {
+    bool passed = true;
+
+    std::weak_ptr<TcpConn> queued;
+    std::weak_ptr<TcpConn> timed;
+    int clients[2];
+    int servers[2];
+    {
+        EventLoop loop;
+        std::shared_ptr<TcpConn> conns[2];
+        int reads = 0;
+        for (int i = 0; i < 2; i++) {
+            passed &= LoopbackPair(&clients[i], &servers[i]);
+            conns[i] = std::make_shared<TcpConn>(servers[i], loop);
+            // 读回调不取走数据，读缓冲区一直占着缓冲块池的块
+            conns[i]->SetReadCallback([&]() {
+                if (++reads == 2) {
+                    loop.Quit();
+                }
+            });
+            passed &= SendAll(clients[i], "unread");
+        }
+        loop.RunAfter(5000, [&]() { loop.Quit(); });
+        loop.Run();
+        passed &= (reads == 2);
+
+        queued = conns[0];
+        timed = conns[1];
+        loop.QueueInLoop([conn = conns[0]]() {});
+        loop.GetTimer().AddTimeout(100000, [conn = conns[1]]() {});
+        conns[0].reset();
+        conns[1].reset();
+        passed &= !queued.expired() && !timed.expired();
+    }
+    passed &= queued.expired() && timed.expired();
+    for (int i = 0; i < 2; i++) {
+        passed &= PeerClosed(clients[i]);
+        close(clients[i]);
+    }
+
+    PrintTestResult("TestLoopTeardownReleasesConnections", passed);
+}
+
+// 测试9: IO 线程的 Run 提前返回后 loop 随线程析构：之后分给它的新连接直接关闭，析构服务器时不再访问它
+// （loop 在 IO 线程栈上，访问已析构的 loop 需以 ASAN_OPTIONS=detect_stack_use_after_return=1 运行才能查出）
+void TestLoopExitedEarly() {
+    EventLoop loop;
+    bool passed = true;
+
+    auto server = std::make_unique<TcpServer>(loop, 1);
+    uint16_t port = FreePort();
+    std::atomic<int> callbacks(0);
+    // 在 IO 线程中让它自己的 loop 退出，模拟 epoll_wait 出错时 Run 返回
+    passed &= server->Start(port, [&](TcpConn::Ptr conn) {
+        callbacks++;
+        conn->GetLoop().Quit();
+    });
+
+    int clients[2];
+    for (int& fd : clients) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+    auto client = std::async(std::launch::async, [&]() {
+        bool ok = Connect(clients[0], port);
+        ok &= PeerClosed(clients[0]);     // IO 线程退出时释放它的连接
+        ok &= Connect(clients[1], port);
+        ok &= PeerClosed(clients[1]);
+        loop.Quit();
+        return ok;
+    });
+    loop.Run();
+    passed &= client.get();
+    passed &= (callbacks == 1);
+
+    server.reset();
+
+    close(clients[0]);
+    close(clients[1]);
+    PrintTestResult("TestLoopExitedEarly", passed);
+}
+
+int main() {
+    TestReadBeforePeerShutdown(true);
+    TestReadBeforePeerShutdown(false);
+    TestEdgeTriggeredBudgetYield();
+    TestMaxConnections();
+    TestShedOnFdExhaustion();
+    TestSharedSource();
+    TestStartFailure();
+    TestTeardownPendingConnection();
+    TestLoopTeardownReleasesConnections();
+    TestLoopExitedEarly();
+    std::cout << "\nAll tests completed." << std::endl;
+    return 0;
+}
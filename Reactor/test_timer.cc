@@ -0,0 +1,300 @@
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include "EventLoop.h"
+
+// 统计 operator new 的调用次数，用来确认定时器在稳定状态下不分配内存
+// 替换全部形式的 operator new / delete（普通、数组、对齐、nothrow、带大小），保证分配与释放成对；
+// 全部不内联，免得编译器在调用处看到 malloc / free 与 operator new / delete 交叉配对而报 -Wmismatched-new-delete
+std::atomic<size_t> g_allocations{0};
+
+namespace {
+
+void* CountedAlloc(size_t size, size_t alignment) {
+    g_allocations++;
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+void* CountedAllocOrThrow(size_t size, size_t alignment) {
+    if (void* p = CountedAlloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+__attribute__((noinline)) void* operator new(size_t size) { return CountedAllocOrThrow(size, 0); }
+__attribute__((noinline)) void* operator new[](size_t size) { return CountedAllocOrThrow(size, 0); }
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t al) { return CountedAllocOrThrow(size, static_cast<size_t>(al)); }
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t al) { return CountedAllocOrThrow(size, static_cast<size_t>(al)); }
+__attribute__((noinline)) void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+__attribute__((noinline)) void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<size_t>(al));
+}
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<size_t>(al));
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+// 辅助打印函数
+void PrintTestResult(const char* test_name, bool passed) {
+    std::cout << test_name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// 测试1: 各层之间的 cascade，以及超出最高层范围（2^32 - 1 ms）的定时器
+// 到期时间用 AddTimeoutAt 精确到微秒，直接以 HandleTimeout(now_us) 推进时间，不必真的等待
+void TestCascade() {
+    Timer timer;
+    bool passed = true;
+
+    // 覆盖每层的边界两侧，最后一个超出最高层范围
+    std::vector<uint64_t> delays = {1, 255, 256, 257, 1000, 16383, 16384, 16385,
+                                    (1u << 20) + 1, (1u << 26) + 3, UINT32_MAX, (uint64_t(1) << 32) + 12345};
+    std::vector<uint64_t> deadlines;
+    std::vector<uint64_t> fired(delays.size(), 0);
+    uint64_t now_us = 0;
+    uint64_t base = Timer::GetCurrentTimeUs();
+    for (size_t i = 0; i < delays.size(); i++) {
+        deadlines.push_back(base + delays[i] * 1000 + 17);
+        timer.AddTimeoutAt(deadlines[i], [&, i]() { fired[i] = now_us; });
+    }
+
+    for (size_t i = 0; i < delays.size(); i++) {
+        now_us = deadlines[i] - 1;
+        timer.HandleTimeout(now_us);
+        passed &= (fired[i] == 0);
+        now_us = deadlines[i];
+        timer.HandleTimeout(now_us);
+        passed &= (fired[i] == deadlines[i]);
+    }
+    passed &= (timer.WaitTime() == -1);
+
+    PrintTestResult("TestCascade", passed);
+}
+
+// 测试2: TimerId 的代数检查：节点被复用后，旧句柄既删不掉新定时器，也不会误报成功
+void TestStaleTimerId() {
+    Timer timer;
+    bool passed = true;
+
+    int fired = 0;
+    TimerId first = timer.AddTimeout(10, [&]() { fired += 1; });
+    passed &= timer.DelTimeout(first);
+    passed &= !timer.DelTimeout(first);
+
+    TimerId second = timer.AddTimeout(10, [&]() { fired += 10; });
+    passed &= (second.index == first.index && second.generation != first.generation);
+    passed &= !timer.DelTimeout(first);
+    uint64_t now_us = Timer::GetCurrentTimeUs() + 10000;
+    timer.HandleTimeout(now_us);
+    passed &= (fired == 10);
+    passed &= !timer.DelTimeout(second);   // 已到期
+
+    // 同一时刻到期的两个定时器互相删除：先执行的一个删掉尚未执行的另一个
+    uint64_t deadline = now_us + 5000;
+    TimerId pair[2];
+    int pair_fired = 0;
+    int pair_deleted = 0;
+    for (int i = 0; i < 2; i++) {
+        pair[i] = timer.AddTimeoutAt(deadline, [&, i]() {
+            pair_fired++;
+            pair_deleted += timer.DelTimeout(pair[1 - i]);
+        });
+    }
+    // 一次性定时器在自己的回调中已失效，删除自身返回 false
+    TimerId self;
+    bool deleted_self = true;
+    self = timer.AddTimeoutAt(deadline, [&]() { deleted_self = timer.DelTimeout(self); });
+    timer.HandleTimeout(deadline);
+    passed &= (pair_fired == 1 && pair_deleted == 1);
+    passed &= !deleted_self;
+
+    passed &= !timer.DelTimeout(TimerId{});
+    passed &= !timer.DelTimeout(TimerId{1u << 30, 1});
+
+    PrintTestResult("TestStaleTimerId", passed);
+}
+
+// 测试3: 节点池复用：节点到期或删除后回到空闲链表，再添加时复用已有的块，不再分配内存
+void TestNodePool() {
+    Timer timer;
+    bool passed = true;
+
+    // 超过一块（256 个）节点
+    const int kCount = 300;
+    auto token = std::make_shared<int>(0);
+    std::vector<uint32_t> first_round;
+    for (int i = 0; i < kCount; i++) {
+        first_round.push_back(timer.AddTimeout(1 + i % 50, [token]() { (*token)++; }).index);
+    }
+    passed &= (token.use_count() == kCount + 1);
+    timer.HandleTimeout(Timer::GetCurrentTimeUs() + 1000000);
+    passed &= (*token == kCount);
+    passed &= (token.use_count() == 1);    // 回调执行后立即销毁，释放捕获
+
+    std::vector<TimerId> ids;
+    std::vector<uint32_t> second_round;
+    ids.reserve(kCount);
+    second_round.reserve(kCount);
+    size_t allocations = g_allocations;
+    for (int i = 0; i < kCount; i++) {
+        ids.push_back(timer.AddTimeout(1000, [token]() { (*token)++; }));
+        second_round.push_back(ids.back().index);
+    }
+    passed &= (g_allocations == allocations);
+    std::sort(first_round.begin(), first_round.end());
+    std::sort(second_round.begin(), second_round.end());
+    passed &= (first_round == second_round);
+
+    // 删除同样立即释放捕获
+    for (TimerId id : ids) {
+        passed &= timer.DelTimeout(id);
+    }
+    passed &= (token.use_count() == 1);
+    passed &= (*token == kCount);
+
+    PrintTestResult("TestNodePool", passed);
+}
+
+// 测试4: 超过内联缓冲区（kInlineSize 字节）的回调放到堆上，执行、删除时的行为与内联存放的相同
+void TestLargeCallback() {
+    Timer timer;
+    bool passed = true;
+
+    // 先让节点池分配好，之后只有放不进内联缓冲区的回调需要分配
+    timer.AddTimeout(1, []() {});
+    timer.HandleTimeout(Timer::GetCurrentTimeUs() + 1000000);
+
+    std::array<uint64_t, 16> payload;
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = i * i;
+    }
+    static_assert(sizeof(payload) > InlineCallback<void()>::kInlineSize, "payload 需超过内联缓冲区");
+    auto token = std::make_shared<int>(0);
+    uint64_t sum = 0;
+
+    size_t allocations = g_allocations;
+    timer.AddTimeout(1, [&sum]() { sum += 1; });
+    passed &= (g_allocations == allocations);   // 小回调内联存放
+    timer.AddTimeout(1, [payload, token, &sum]() { for (uint64_t v : payload) sum += v; (*token)++; });
+    passed &= (g_allocations == allocations + 1);
+    TimerId deleted = timer.AddTimeout(1, [payload, token]() { (*token) += 100; });
+    passed &= (token.use_count() == 3);
+    passed &= timer.DelTimeout(deleted);
+    passed &= (token.use_count() == 2);        // 删除时释放堆上的回调
+    timer.HandleTimeout(Timer::GetCurrentTimeUs() + 1000000);
+    passed &= (sum == 1 + 1240);
+    passed &= (*token == 1);
+    passed &= (token.use_count() == 1);
+
+    PrintTestResult("TestLargeCallback", passed);
+}
+
+// 测试5: timerfd 驱动时按到期时间先后触发，且不会早于到期时间
+void TestTimerFdOrder() {
+    EventLoop loop(true);
+    bool passed = loop.UsesTimerFd();
+
+    // 乱序添加，到期时间间隔 500us，低于 epoll_wait 超时的毫秒精度
+    std::vector<int> delays = {3000, 500, 2500, 1000, 4000, 1500, 3500, 2000};
+    std::vector<int> order;
+    for (int delay : delays) {
+        uint64_t deadline = Timer::GetCurrentTimeUs() + delay;
+        loop.RunAfter(std::chrono::microseconds(delay), [&, delay, deadline]() {
+            passed &= (Timer::GetCurrentTimeUs() >= deadline);
+            order.push_back(delay);
+            if (order.size() == delays.size()) {
+                loop.Quit();
+            }
+        });
+    }
+    // 兜底：出错时不至于一直阻塞
+    loop.RunAfter(1000, [&]() { loop.Quit(); });
+    loop.Run();
+
+    std::sort(delays.begin(), delays.end());
+    passed &= (order == delays);
+
+    PrintTestResult("TestTimerFdOrder", passed);
+}
+
+// 测试6: 其他线程并发调用 RunAfter：回调全部在 loop 所属线程执行，不早于到期时间，一个不少
+void TestCrossThreadRunAfter(bool use_timerfd) {
+    EventLoop loop(use_timerfd);
+    bool passed = (loop.UsesTimerFd() == use_timerfd);
+
+    const int kThreads = 4;
+    const int kPerThread = 200;
+    int fired = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kPerThread; i++) {
+                int delay_us = (t * kPerThread + i) % 37 * 100;
+                uint64_t deadline = Timer::GetCurrentTimeUs() + delay_us;
+                loop.RunAfter(std::chrono::microseconds(delay_us), [&, deadline]() {
+                    passed &= loop.IsInLoopThread();
+                    passed &= (Timer::GetCurrentTimeUs() >= deadline);
+                    if (++fired == kThreads * kPerThread) {
+                        loop.Quit();
+                    }
+                });
+            }
+        });
+    }
+    // 兜底：出错时不至于一直阻塞
+    loop.RunAfter(5000, [&]() { loop.Quit(); });
+    loop.Run();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    passed &= (fired == kThreads * kPerThread);
+
+    PrintTestResult(use_timerfd ? "TestCrossThreadRunAfter(timerfd)" : "TestCrossThreadRunAfter", passed);
+}
+
+int main() {
+    TestCascade();
+    TestStaleTimerId();
+    TestNodePool();
+    TestLargeCallback();
+    TestTimerFdOrder();
+    TestCrossThreadRunAfter(false);
+    TestCrossThreadRunAfter(true);
+    std::cout << "\nAll tests completed." << std::endl;
+    return 0;
+}
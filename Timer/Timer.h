@@ -7,14 +7,19 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <sys/epoll.h>
 #include <functional>
 #include <chrono>
-#include <map>
 #include <memory>
 #include <iostream>
 #include <sys/types.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /*
     实现要点：
@@ -22,7 +27,18 @@
     2. 定时器类实现要点：
         提供的接口：
             添加定时器，删除定时器，处理定时器，获取下一个定时器的等待时间；
-        内部维护一个有序的定时器容器，使用multimap实现,key为到期时间，value为任务指针；
+        内部使用分层时间轮维护定时器：
+            精度 1ms，第 0 层 256 个槽，第 1~4 层各 64 个槽，共覆盖 2^32 ms（约 49 天），更远的定时器先挂在最高层；
+            每个槽是侵入式双向链表，添加、删除定时器均为 O(1)；
+            第 0 层转完一圈时，把上一层当前槽的任务按剩余时间重新分配到下层（cascade），逐层向上同理；
+            每个槽对应位图中的一位，推进时跳过空槽，处理开销与到期任务数和经过的圈数成正比；
+        添加定时器返回TimerId（任务表下标 + 代数），任务到期或删除后代数加一，
+        旧句柄随之失效，删除已到期的定时器是安全的；
+        任务按块（每块256个）预分配，释放后挂回空闲链表复用；回调存放在任务内的InlineCallback中，
+        捕获不超过48字节时不额外分配内存，稳定运行后添加定时器没有malloc；
+        AddPeriodicTimer添加周期定时器，按 首次到期时间 + k * interval 重新挂回时间轮，不累积漂移，错过的周期直接跳过；
+        slack允许在[到期时间, 到期时间 + slack]内任意时刻触发，实际触发时间取区间内低位0最多的时刻，
+        相近的定时器因此落到同一时刻，合并为一次唤醒；
         
 */
 
@@ -30,23 +46,137 @@
 
 using namespace std;
 class Timer;
+
+//只可移动的回调：不超过kInlineSize字节且可noexcept移动的可调用对象直接构造在内部缓冲区，否则放到堆上
+template<class Signature>
+class InlineCallback;
+
+template<class R, class... Args>
+class InlineCallback<R(Args...)> {
+public:
+    static constexpr size_t kInlineSize = 48;
+
+    InlineCallback() noexcept : m_ops(nullptr) {}
+
+    template<class F, class = enable_if_t<!is_same_v<decay_t<F>, InlineCallback>>>
+    InlineCallback(F&& f) : m_ops(nullptr) {
+        emplace(std::forward<F>(f));
+    }
+
+    InlineCallback(InlineCallback&& other) noexcept : m_ops(other.m_ops) {
+        if(m_ops) {
+            m_ops->move(m_storage, other.m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    InlineCallback& operator=(InlineCallback&& other) noexcept {
+        if(this != &other) {
+            reset();
+            m_ops = other.m_ops;
+            if(m_ops) {
+                m_ops->move(m_storage, other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineCallback(const InlineCallback&) = delete;
+    InlineCallback& operator=(const InlineCallback&) = delete;
+
+    ~InlineCallback() {
+        reset();
+    }
+
+    template<class F>
+    void emplace(F&& f) {
+        using Fn = decay_t<F>;
+        reset();
+        if constexpr (kFitsInline<Fn>) {
+            new (m_storage) Fn(std::forward<F>(f));
+            m_ops = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(f));
+            m_ops = &kHeapOps<Fn>;
+        }
+    }
+
+    void reset() {
+        if(m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    R operator()(Args... args) {
+        return m_ops->invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void*, Args&&...);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template<class Fn>
+    static constexpr bool kFitsInline = sizeof(Fn) <= kInlineSize &&
+                                        alignof(Fn) <= alignof(max_align_t) &&
+                                        is_nothrow_move_constructible_v<Fn>;
+
+    template<class Fn>
+    static constexpr Ops kInlineOps = {
+        [](void* p, Args&&... args) -> R { return (*static_cast<Fn*>(p))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template<class Fn>
+    static constexpr Ops kHeapOps = {
+        [](void* p, Args&&... args) -> R { return (**static_cast<Fn**>(p))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+
+    alignas(max_align_t) unsigned char m_storage[kInlineSize];
+    const Ops* m_ops;
+};
+
+struct TimerId {
+    uint32_t index = 0;         //在任务表中的下标
+    uint32_t generation = 0;    //分配时的代数，0表示无效句柄
+};
+
 class TimerTask{
     friend class Timer;
 public:
-    using cb = function<void(TimerTask*)>;
-    TimerTask(uint add_time, uint expire_time, cb callback):
-        m_add_time(add_time),
-        m_expire_time(expire_time),
-        m_callback(callback) 
+    using cb = InlineCallback<void(TimerTask*)>;
+    TimerTask():
+        m_add_time(0),
+        m_expire_time(0),
+        m_fire_time(0),
+        m_interval(0),
+        m_slack(0),
+        m_slot(kNoSlot),
+        m_index(0),
+        m_generation(1),
+        m_prev(nullptr),
+        m_next(nullptr)
     {
         
     }
     
-    uint AddTime() const {
+    uint64_t AddTime() const {
         return m_add_time;
     }
 
-    uint ExpireTime() const {
+    uint64_t ExpireTime() const {
         return m_expire_time;
     }
 private:
@@ -54,68 +184,322 @@ private:
         m_callback(this);
     }
 private:
-    uint m_add_time;
-    uint m_expire_time;
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+    static constexpr uint32_t kRunningSlot = UINT32_MAX - 1;   //周期定时器正在执行回调
+
+    uint64_t m_add_time;
+    uint64_t m_expire_time; //名义到期时间
+    uint64_t m_fire_time;   //实际触发时间，即m_expire_time加上slack调整
+    uint64_t m_interval;    //周期，0表示一次性定时器
+    uint64_t m_slack;
     cb m_callback;
+    uint32_t m_slot;        //所在槽位，kNoSlot表示不在时间轮上
+    uint32_t m_index;       //在任务池中的下标
+    uint32_t m_generation;  //每次到期或删除时加一，与TimerId比对
+    TimerTask* m_prev;      //时间轮槽位内的双向链表
+    TimerTask* m_next;      //空闲时复用为空闲链表指针
 };
 
 
 class Timer {
 using Milliseconds = std::chrono::milliseconds;
 public:
+    Timer() : m_current(GetTick()) {}
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    ~Timer() = default;
+
     static uint64_t GetTick() {
         auto sc = chrono::time_point_cast<Milliseconds>(chrono::steady_clock::now());
         auto temp = chrono::duration_cast<Milliseconds>(sc.time_since_epoch());
         return temp.count();
     }
 
-    //添加一个定时器，after_sec秒后到期，执行callback回调函数
-    TimerTask* AddTimer(uint after_sec, TimerTask::cb callback) {
-        time_t now = GetTick();
-        TimerTask* task = new TimerTask(now, now + after_sec, callback);
-        //如果当前定时器队列为空，或者新添加的定时器到期时间大于最后一个定时器的到期时间，直接插入到末尾
-        if(m_timer_map.empty() || m_timer_map.rbegin()->first < now + after_sec) {
-            m_timer_map.emplace_hint(m_timer_map.end(), now + after_sec, task);
-            return task;
-        }
-        auto ele = m_timer_map.emplace(now + after_sec, task);
-        return ele->second;
+    //添加一个定时器，after_sec毫秒后到期，执行callback回调函数；slack为允许推迟触发的毫秒数
+    template<class F>
+    TimerId AddTimer(uint after_sec, F&& callback, uint slack = 0) {
+        return schedule(after_sec, 0, slack, std::forward<F>(callback));
     }
 
-    //删除一个定时器
-    void DelTimer(TimerTask* task) {
-        for(auto it = m_timer_map.begin(); it != m_timer_map.end(); ++it) {
-            if(it->second == task) {
-                m_timer_map.erase(it);
-                delete task;
-                break;
-            }
+    //添加一个周期定时器，每interval毫秒执行一次callback，直到DelTimer
+    template<class F>
+    TimerId AddPeriodicTimer(uint interval, F&& callback, uint slack = 0) {
+        return schedule(interval == 0 ? 1 : interval, interval == 0 ? 1 : interval, slack, std::forward<F>(callback));
+    }
+
+    //删除一个定时器，O(1)；句柄已失效（已到期或已删除）时返回false
+    bool DelTimer(TimerId id) {
+        if(id.index >= m_chunks.size() * kChunkSize) {
+            return false;
+        }
+        TimerTask* task = task_at(id.index);
+        if(task->m_generation != id.generation || task->m_slot == TimerTask::kNoSlot) {
+            return false;
+        }
+        if(task->m_slot == TimerTask::kRunningSlot) {
+            //周期定时器在自己的回调中删除自身：只让句柄失效，回调返回后由advance回收
+            retire_task(task);
+            return true;
         }
+        unlink(task);
+        retire_task(task);
+        free_task(task);
+        return true;
     }
 
     void HandleTimer(time_t now) {
-        auto it = m_timer_map.begin();
-        while(it != m_timer_map.end() && it->first <= now) {
-            TimerTask* task = it->second;
-            task->run();
-            delete task;
-            it = m_timer_map.erase(it);
-        }   
+        advance(now);
     }
 
 
+    //距最近一个定时器到期的毫秒数，没有定时器时返回-1
+    //高层槽位只能给出下界，提前醒来时HandleTimer会完成cascade，下一轮再给出准确值
     uint WaitTime(){
-        auto it = m_timer_map.begin();
-        if(it == m_timer_map.end()){
+        if(m_count == 0){
             return -1;
         }
-        uint diss = it->first - GetTick();
-        return diss > 0 ? diss : 0;
+        uint64_t next = next_expire_time();
+        uint64_t now = GetTick();
+        if(next <= now) {
+            return 0;
+        }
+        return next - now > INT_MAX ? INT_MAX : next - now;
+    }
+
+
+private:
+    static constexpr int kLevels = 5;
+    static constexpr int kLevel0Bits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr uint32_t kLevel0Slots = 1u << kLevel0Bits;
+    static constexpr uint32_t kLevelSlots = 1u << kLevelBits;
+    static constexpr uint32_t kTotalSlots = kLevel0Slots + (kLevels - 1) * kLevelSlots;
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kLevel0Bits + (kLevels - 1) * kLevelBits)) - 1;
+
+    //第level层的起始槽位，以及该层一个槽覆盖的时间（2^shift毫秒）
+    static uint32_t level_offset(int level) {
+        return level == 0 ? 0 : kLevel0Slots + (level - 1) * kLevelSlots;
+    }
+    static int level_shift(int level) {
+        return level == 0 ? 0 : kLevel0Bits + (level - 1) * kLevelBits;
+    }
+
+    template<class F>
+    TimerId schedule(uint64_t after, uint64_t interval, uint64_t slack, F&& callback) {
+        uint64_t now = GetTick();
+        TimerTask* task = alloc_task();
+        task->m_add_time = now;
+        task->m_expire_time = now + after;
+        task->m_interval = interval;
+        task->m_slack = slack;
+        task->m_fire_time = apply_slack(task->m_expire_time, slack);
+        task->m_callback.emplace(std::forward<F>(callback));
+        link(task);
+        return TimerId{task->m_index, task->m_generation};
+    }
+
+    //在[expire, expire + slack]中取低位0最多的时刻，相近的到期时间因此对齐到同一时刻
+    static uint64_t apply_slack(uint64_t expire, uint64_t slack) {
+        if(slack == 0) {
+            return expire;
+        }
+        uint64_t limit = expire + slack;
+        int bit = 63 - __builtin_clzll(expire ^ limit);
+        return limit & ~((uint64_t(1) << bit) - 1);
+    }
+
+    static constexpr uint32_t kChunkBits = 8;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+
+    TimerTask* task_at(uint32_t index) {
+        return &m_chunks[index >> kChunkBits][index & (kChunkSize - 1)];
     }
 
+    //从空闲链表取任务，空闲链表为空时整块分配kChunkSize个
+    TimerTask* alloc_task() {
+        if(!m_free_list) {
+            uint32_t base = static_cast<uint32_t>(m_chunks.size()) * kChunkSize;
+            m_chunks.emplace_back(new TimerTask[kChunkSize]);
+            TimerTask* chunk = m_chunks.back().get();
+            for(uint32_t i = kChunkSize; i-- > 0;) {
+                chunk[i].m_index = base + i;
+                chunk[i].m_next = m_free_list;
+                m_free_list = &chunk[i];
+            }
+        }
+        TimerTask* task = m_free_list;
+        m_free_list = task->m_next;
+        task->m_next = nullptr;
+        return task;
+    }
+
+    //使该任务的TimerId失效
+    void retire_task(TimerTask* task) {
+        if(++task->m_generation == 0) {
+            task->m_generation = 1;
+        }
+    }
+
+    //销毁回调（释放捕获的资源）并放回空闲链表
+    void free_task(TimerTask* task) {
+        task->m_callback.reset();
+        task->m_next = m_free_list;
+        m_free_list = task;
+    }
+
+    void link(TimerTask* task) {
+        //已经到期的任务放在当前槽，下一次推进时立即执行
+        uint64_t expire = task->m_fire_time < m_current ? m_current : task->m_fire_time;
+        uint64_t delta = expire - m_current;
+        if(delta > kMaxDelta) {
+            expire = m_current + kMaxDelta;
+            delta = kMaxDelta;
+        }
+        int level = 0;
+        while(level < kLevels - 1 && delta >> level_shift(level + 1) != 0) {
+            level++;
+        }
+        uint32_t slots = level == 0 ? kLevel0Slots : kLevelSlots;
+        uint32_t slot = level_offset(level) + static_cast<uint32_t>((expire >> level_shift(level)) & (slots - 1));
+
+        task->m_slot = slot;
+        task->m_prev = nullptr;
+        task->m_next = m_slots[slot];
+        if(m_slots[slot]) {
+            m_slots[slot]->m_prev = task;
+        }
+        m_slots[slot] = task;
+        m_bitmap[slot / 64] |= uint64_t(1) << (slot % 64);
+        m_count++;
+    }
+
+    void unlink(TimerTask* task) {
+        uint32_t slot = task->m_slot;
+        if(task->m_prev) {
+            task->m_prev->m_next = task->m_next;
+        } else {
+            m_slots[slot] = task->m_next;
+            if(!m_slots[slot]) {
+                m_bitmap[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+            }
+        }
+        if(task->m_next) {
+            task->m_next->m_prev = task->m_prev;
+        }
+        task->m_slot = TimerTask::kNoSlot;
+        task->m_prev = task->m_next = nullptr;
+        m_count--;
+    }
+
+    //在[begin, end)中查找第一个非空槽，没有时返回end
+    uint32_t find_slot(uint32_t begin, uint32_t end) const {
+        while(begin < end) {
+            uint64_t word = m_bitmap[begin / 64] >> (begin % 64);
+            if(word) {
+                uint32_t found = begin + __builtin_ctzll(word);
+                return found < end ? found : end;
+            }
+            begin = (begin / 64 + 1) * 64;
+        }
+        return end;
+    }
+
+    //把第level层当前槽的任务重新分配到下层，返回槽下标（为0时需要继续cascade上一层）
+    uint32_t cascade(int level) {
+        uint32_t index = static_cast<uint32_t>((m_current >> level_shift(level)) & (kLevelSlots - 1));
+        uint32_t slot = level_offset(level) + index;
+        TimerTask* task = m_slots[slot];
+        m_slots[slot] = nullptr;
+        m_bitmap[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        while(task) {
+            TimerTask* next = task->m_next;
+            m_count--;
+            link(task);
+            task = next;
+        }
+        return index;
+    }
+
+    //推进到now，依次执行(m_current, now]之间到期的任务
+    void advance(uint64_t now) {
+        while(m_current <= now) {
+            if(m_count == 0) {
+                m_current = now + 1;
+                break;
+            }
+            uint32_t index = static_cast<uint32_t>(m_current & (kLevel0Slots - 1));
+            if(index == 0) {
+                for(int level = 1; level < kLevels && cascade(level) == 0; level++) {
+                }
+            }
+            //回调中可能增删定时器，每次都从槽头部重新取
+            //一次性定时器回调前先让句柄失效（回调中删除自身会返回false），回调结束后才放回空闲链表，避免执行中被复用
+            while(TimerTask* task = m_slots[index]) {
+                unlink(task);
+                if(task->m_interval == 0) {
+                    retire_task(task);
+                    task->run();
+                    free_task(task);
+                    continue;
+                }
+                uint32_t generation = task->m_generation;
+                task->m_slot = TimerTask::kRunningSlot;
+                task->run();
+                if(task->m_generation != generation) {
+                    free_task(task);    //回调中被删除
+                    continue;
+                }
+                //下一个名义到期时间：首次到期时间 + k * interval，且晚于now
+                uint64_t expire = task->m_expire_time + task->m_interval;
+                if(expire <= now) {
+                    expire += ((now - expire) / task->m_interval + 1) * task->m_interval;
+                }
+                task->m_expire_time = expire;
+                task->m_fire_time = apply_slack(expire, task->m_slack);
+                link(task);
+            }
+            //跳到下一个非空槽；本圈没有则跳到下一圈起点做cascade，但不越过now + 1
+            uint64_t next = m_current + (find_slot(index + 1, kLevel0Slots) - index);
+            m_current = next < now + 1 ? next : now + 1;
+        }
+    }
+
+    //最近到期时间的下界：第0层为精确值，高层取对应槽cascade的时刻
+    uint64_t next_expire_time() const {
+        uint64_t next = UINT64_MAX;
+        for(int level = 0; level < kLevels; level++) {
+            int shift = level_shift(level);
+            uint32_t slots = level == 0 ? kLevel0Slots : kLevelSlots;
+            uint32_t offset = level_offset(level);
+            //本层下一个槽边界（第0层即m_current本身）
+            uint64_t base = ((m_current + (uint64_t(1) << shift) - 1) >> shift) << shift;
+            uint32_t index = static_cast<uint32_t>((base >> shift) & (slots - 1));
+            uint32_t found = find_slot(offset + index, offset + slots);
+            uint64_t distance;
+            if(found != offset + slots) {
+                distance = found - offset - index;
+            } else {
+                found = find_slot(offset, offset + index);
+                if(found == offset + index) {
+                    continue;
+                }
+                distance = found - offset + slots - index;
+            }
+            uint64_t expire = base + (distance << shift);
+            next = expire < next ? expire : next;
+        }
+        return next;
+    }
 
 private:
-    multimap<time_t, TimerTask*> m_timer_map;
+    vector<unique_ptr<TimerTask[]>> m_chunks;   //任务池，按块分配，地址稳定
+    TimerTask* m_free_list = nullptr;
+    TimerTask* m_slots[kTotalSlots] = {};
+    uint64_t m_bitmap[kTotalSlots / 64] = {};
+    uint64_t m_current;     //下一个待处理的tick
+    size_t m_count = 0;
 };
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,250 @@
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+#include "Timer.h"
+
+// 统计 operator new 的调用次数，用来确认定时器在稳定状态下不分配内存
+// 替换全部形式的 operator new / delete（普通、数组、对齐、nothrow、带大小），保证分配与释放成对；
+// 全部不内联，免得编译器在调用处看到 malloc / free 与 operator new / delete 交叉配对而报 -Wmismatched-new-delete
+size_t g_allocations = 0;
+
+namespace {
+
+void* CountedAlloc(size_t size, size_t alignment) {
+    g_allocations++;
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+void* CountedAllocOrThrow(size_t size, size_t alignment) {
+    if (void* p = CountedAlloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+__attribute__((noinline)) void* operator new(size_t size) { return CountedAllocOrThrow(size, 0); }
+__attribute__((noinline)) void* operator new[](size_t size) { return CountedAllocOrThrow(size, 0); }
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t al) { return CountedAllocOrThrow(size, static_cast<size_t>(al)); }
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t al) { return CountedAllocOrThrow(size, static_cast<size_t>(al)); }
+__attribute__((noinline)) void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+__attribute__((noinline)) void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<size_t>(al));
+}
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<size_t>(al));
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+// 辅助打印函数；记录是否有测试失败，作为进程退出码交给 ctest
+bool g_failed = false;
+
+void PrintTestResult(const char* test_name, bool passed) {
+    std::cout << test_name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+    g_failed |= !passed;
+}
+
+// 传给 HandleTimer 的时间：测试直接推进这个虚拟时钟，不必真的等待
+uint64_t g_now = 0;
+
+void Advance(Timer& timer, uint64_t now) {
+    g_now = now;
+    timer.HandleTimer(now);
+}
+
+// 测试1: 各层之间的 cascade，以及超出最高层范围（2^32 - 1 ms）的定时器
+void TestCascade() {
+    Timer timer;
+    bool passed = true;
+
+    // 覆盖每层的边界两侧
+    std::vector<uint64_t> delays = {1, 255, 256, 257, 1000, 16383, 16384, 16385,
+                                    (1u << 20) + 1, (1u << 26) + 3, UINT32_MAX};
+    std::vector<uint64_t> fired(delays.size(), 0);
+    uint64_t start = Timer::GetTick();
+    for (size_t i = 0; i < delays.size(); i++) {
+        timer.AddTimer(delays[i], [&, i](TimerTask* task) {
+            passed &= (task->ExpireTime() <= g_now);    // 不会提前触发
+            fired[i] = g_now;
+        });
+    }
+    // slack 把实际触发时间推到最高层范围之外，先挂在最高层，cascade 时再按剩余时间重新分配
+    const uint32_t slack = 1u << 20;
+    uint64_t beyond_fired = 0;
+    timer.AddTimer(UINT32_MAX, [&](TimerTask* task) {
+        passed &= (task->ExpireTime() <= g_now);
+        beyond_fired = g_now;
+    }, slack);
+    uint64_t end = Timer::GetTick();
+
+    for (size_t i = 0; i < delays.size(); i++) {
+        Advance(timer, start + delays[i] - 1);
+        passed &= (fired[i] == 0);
+        Advance(timer, end + delays[i]);
+        passed &= (fired[i] != 0);
+    }
+    passed &= (beyond_fired == 0);
+    Advance(timer, end + UINT32_MAX + slack);
+    passed &= (beyond_fired != 0);
+    passed &= (timer.WaitTime() == static_cast<uint>(-1));
+
+    PrintTestResult("TestCascade", passed);
+}
+
+// 测试2: TimerId 的代数检查：节点被复用后，旧句柄既删不掉新定时器，也不会误报成功
+void TestStaleTimerId() {
+    Timer timer;
+    bool passed = true;
+
+    int fired = 0;
+    TimerId first = timer.AddTimer(10, [&](TimerTask*) { fired += 1; });
+    passed &= timer.DelTimer(first);
+    passed &= !timer.DelTimer(first);
+
+    TimerId second = timer.AddTimer(10, [&](TimerTask*) { fired += 10; });
+    passed &= (second.index == first.index && second.generation != first.generation);
+    passed &= !timer.DelTimer(first);
+    Advance(timer, Timer::GetTick() + 10);
+    passed &= (fired == 10);
+    uint64_t next = g_now + 5;
+    passed &= !timer.DelTimer(second);     // 已到期
+
+    // 同一时刻到期的两个定时器互相删除：先执行的一个删掉尚未执行的另一个
+    TimerId pair[2];
+    int pair_fired = 0;
+    int pair_deleted = 0;
+    for (int i = 0; i < 2; i++) {
+        pair[i] = timer.AddTimer(1, [&, i](TimerTask*) {
+            pair_fired++;
+            pair_deleted += timer.DelTimer(pair[1 - i]);
+        });
+    }
+    // 一次性定时器在自己的回调中已失效，删除自身返回 false
+    TimerId self;
+    bool deleted_self = true;
+    self = timer.AddTimer(1, [&](TimerTask*) { deleted_self = timer.DelTimer(self); });
+    Advance(timer, next);
+    passed &= (pair_fired == 1 && pair_deleted == 1);
+    passed &= !deleted_self;
+
+    passed &= !timer.DelTimer(TimerId{});
+    passed &= !timer.DelTimer(TimerId{1u << 30, 1});
+
+    PrintTestResult("TestStaleTimerId", passed);
+}
+
+// 测试3: 节点池复用：节点到期或删除后回到空闲链表，再添加时复用已有的块，不再分配内存
+void TestNodePool() {
+    Timer timer;
+    bool passed = true;
+
+    // 超过一块（256 个）节点
+    const int kCount = 300;
+    auto token = std::make_shared<int>(0);
+    std::vector<uint32_t> first_round;
+    for (int i = 0; i < kCount; i++) {
+        first_round.push_back(timer.AddTimer(1 + i % 50, [token](TimerTask*) { (*token)++; }).index);
+    }
+    passed &= (token.use_count() == kCount + 1);
+    Advance(timer, g_now + 1000);
+    passed &= (*token == kCount);
+    passed &= (token.use_count() == 1);    // 回调执行后立即销毁，释放捕获
+
+    std::vector<TimerId> ids;
+    std::vector<uint32_t> second_round;
+    ids.reserve(kCount);
+    second_round.reserve(kCount);
+    size_t allocations = g_allocations;
+    for (int i = 0; i < kCount; i++) {
+        ids.push_back(timer.AddTimer(1000, [token](TimerTask*) { (*token)++; }));
+        second_round.push_back(ids.back().index);
+    }
+    passed &= (g_allocations == allocations);
+    std::sort(first_round.begin(), first_round.end());
+    std::sort(second_round.begin(), second_round.end());
+    passed &= (first_round == second_round);
+
+    // 删除同样立即释放捕获
+    for (TimerId id : ids) {
+        passed &= timer.DelTimer(id);
+    }
+    passed &= (token.use_count() == 1);
+    passed &= (*token == kCount);
+
+    PrintTestResult("TestNodePool", passed);
+}
+
+// 测试4: 超过内联缓冲区（kInlineSize 字节）的回调放到堆上，执行、删除时的行为与内联存放的相同
+void TestLargeCallback() {
+    Timer timer;
+    bool passed = true;
+
+    // 先让节点池分配好，之后只有放不进内联缓冲区的回调需要分配
+    timer.AddTimer(1, [](TimerTask*) {});
+    Advance(timer, g_now + 1000);
+
+    std::array<uint64_t, 16> payload;
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = i * i;
+    }
+    static_assert(sizeof(payload) > InlineCallback<void()>::kInlineSize, "payload 需超过内联缓冲区");
+    auto token = std::make_shared<int>(0);
+    uint64_t sum = 0;
+
+    size_t allocations = g_allocations;
+    timer.AddTimer(1, [&sum](TimerTask*) { sum += 1; });
+    passed &= (g_allocations == allocations);   // 小回调内联存放
+    timer.AddTimer(1, [payload, token, &sum](TimerTask*) { for (uint64_t v : payload) sum += v; (*token)++; });
+    passed &= (g_allocations == allocations + 1);
+    TimerId deleted = timer.AddTimer(1, [payload, token](TimerTask*) { (*token) += 100; });
+    passed &= (token.use_count() == 3);
+    passed &= timer.DelTimer(deleted);
+    passed &= (token.use_count() == 2);        // 删除时释放堆上的回调
+    Advance(timer, g_now + 1000);
+    passed &= (sum == 1 + 1240);
+    passed &= (*token == 1);
+    passed &= (token.use_count() == 1);
+
+    PrintTestResult("TestLargeCallback", passed);
+}
+
+int main() {
+    TestCascade();
+    TestStaleTimerId();
+    TestNodePool();
+    TestLargeCallback();
+    std::cout << "\nAll tests completed." << std::endl;
+    return g_failed ? 1 : 0;
+}